@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+/*
+ * Time how long it takes to decode the datetimes of directory records and
+ * volume descriptors. Every scan decodes one per file, so it has to be cheap.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "./include/buffer.h"
+#include "./include/read.h"
+
+namespace {
+
+constexpr std::size_t LONG_DATETIME_SIZE = 17;
+constexpr std::size_t SHORT_DATETIME_SIZE = 7;
+constexpr int RUNS = 5;
+
+// Keeps the compiler from dropping the calls.
+volatile std::int64_t result;
+
+std::vector<iso9660::Byte> long_datetimes(std::size_t count,
+                                          std::mt19937* random) {
+  std::uniform_int_distribution<int> year(1970, 2100), month(1, 12),
+      day(1, 28), hour(0, 23), minute(0, 59), offset(-48, 52);
+  std::vector<iso9660::Byte> datetimes;
+  char digits[17];
+  for (std::size_t i = 0; i < count; ++i) {
+    std::snprintf(digits, sizeof(digits), "%04d%02d%02d%02d%02d%02d%02d",
+                  year(*random), month(*random), day(*random), hour(*random),
+                  minute(*random), minute(*random), minute(*random));
+    datetimes.insert(datetimes.end(), digits, digits + 16);
+    datetimes.push_back(static_cast<iso9660::Byte>(offset(*random)));
+  }
+  return datetimes;
+}
+
+std::vector<iso9660::Byte> short_datetimes(std::size_t count,
+                                           std::mt19937* random) {
+  std::uniform_int_distribution<int> year(70, 200), month(1, 12), day(1, 28),
+      hour(0, 23), minute(0, 59), offset(-48, 52);
+  std::vector<iso9660::Byte> datetimes;
+  for (std::size_t i = 0; i < count; ++i) {
+    const int fields[] = {year(*random),   month(*random),  day(*random),
+                          hour(*random),   minute(*random), minute(*random),
+                          offset(*random)};
+    for (const int field : fields) {
+      datetimes.push_back(static_cast<iso9660::Byte>(field));
+    }
+  }
+  return datetimes;
+}
+
+/**
+ * @return Nanoseconds per datetime of the fastest run.
+ */
+double time(const std::vector<iso9660::Byte>& datetimes, std::size_t size,
+            const std::function<std::int64_t(iso9660::Span::const_iterator,
+                                             std::size_t)>& decode) {
+  const std::size_t count = datetimes.size() / size;
+  double fastest = 0;
+  std::int64_t sum = 0;
+  for (int run = 0; run < RUNS; ++run) {
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+      sum += decode(datetimes.data() + i * size, size);
+    }
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    const double per_datetime = elapsed.count() / count;
+    fastest = run == 0 ? per_datetime : std::min(fastest, per_datetime);
+  }
+  result = sum;
+  return fastest;
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  const std::size_t count = argc > 1 ? std::stoul(argv[1]) : 200000;
+  std::mt19937 random(9660);
+  const auto long_input = long_datetimes(count, &random);
+  const auto short_input = short_datetimes(count, &random);
+  std::cout << "short_datetime: "
+            << time(short_input, SHORT_DATETIME_SIZE,
+                    [](iso9660::Span::const_iterator first, std::size_t size) {
+                      return iso9660::read::short_datetime(first, size);
+                    })
+            << " ns\n"
+            << "long_datetime:  "
+            << time(long_input, LONG_DATETIME_SIZE,
+                    [](iso9660::Span::const_iterator first, std::size_t size) {
+                      return iso9660::read::long_datetime(first, size);
+                    })
+            << " ns" << std::endl;
+  return 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+/*
+ * Count the heap allocations and the peak RSS of reading an image and of the
+ * first lookup, which builds the name index. Names are stored once in the
+ * arena of the image, so neither should allocate a string per record.
+ */
+
+#include <sys/resource.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include "./include/iso9660.h"
+
+namespace {
+
+std::atomic<std::size_t> allocations(0);
+
+void report(const std::string& step, std::size_t count) {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  // Linux reports the maximum resident set size in KiB.
+  std::cout << step << ": " << count << " allocations, peak RSS "
+            << usage.ru_maxrss / 1024.0 << " MiB\n";
+}
+
+}  // namespace
+
+/*
+ * Every allocation of the process goes through here, including those of the
+ * library.
+ */
+void* operator new(std::size_t size) {
+  ++allocations;
+  if (void* memory = std::malloc(size == 0 ? 1 : size)) return memory;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+
+int main(int argc, const char* argv[]) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <image.iso> <path>\n"
+              << "Create an image with e.g. test/images/mkiso.py many.iso "
+                 "many-files 50000\nand look up /package-00000.rpm."
+              << std::endl;
+    return 1;
+  }
+  iso9660::MappedFile source(argv[1]);
+  iso9660::Image image(&source);
+  std::size_t before = allocations;
+  image.read();
+  report("read()", allocations - before);
+  before = allocations;
+  const bool found = static_cast<bool>(image.find(argv[2]));
+  report("first find()", allocations - before);
+  if (!found) {
+    std::cerr << "Can't find " << argv[2] << std::endl;
+    return 1;
+  }
+  return 0;
+}
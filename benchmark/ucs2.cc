@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+/*
+ * Time how long it takes to turn Joliet names into UTF-8 for a few kinds of
+ * names as they're found on real images. Every name of the supplementary
+ * volume descriptor goes through this on every scan.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "./include/name-arena.h"
+#include "./include/string-view.h"
+#include "./include/utility.h"
+
+namespace {
+
+constexpr int RUNS = 5;
+
+// Keeps the compiler from dropping the calls.
+volatile std::size_t result;
+
+struct Names {
+  const char* kind;
+  // Formats a name from a random number.
+  std::function<std::string(unsigned)> make;
+};
+
+/**
+ * @return Names in UCS-2 big endian as they're stored in directory records.
+ */
+std::vector<std::string> joliet_names(const Names& names, std::size_t count,
+                                      std::mt19937* random) {
+  std::vector<std::string> encoded;
+  encoded.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    encoded.push_back(utility::to_ucs2(names.make((*random)())));
+  }
+  return encoded;
+}
+
+/**
+ * @return Nanoseconds per name of the fastest run.
+ */
+double time(const std::vector<std::string>& names,
+            const std::function<std::size_t(const std::string&)>& convert) {
+  double fastest = 0;
+  std::size_t sum = 0;
+  for (int run = 0; run < RUNS; ++run) {
+    const auto start = std::chrono::steady_clock::now();
+    for (const std::string& name : names) sum += convert(name);
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    const double per_name = elapsed.count() / names.size();
+    fastest = run == 0 ? per_name : std::min(fastest, per_name);
+  }
+  result = sum;
+  return fastest;
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  const std::size_t count = argc > 1 ? std::stoul(argv[1]) : 50000;
+  const Names kinds[] = {
+      {"ASCII package names",
+       [](unsigned n) {
+         return "python3-package-" + std::to_string(n % 1000) + "-1." +
+                std::to_string(n % 97) + "-2.fc26.noarch.rpm";
+       }},
+      {"Latin-1 accents",
+       [](unsigned n) {
+         return u8"Résumé de l'année " + std::to_string(n % 10000) +
+                u8" – été.odt";
+       }},
+      {"CJK prefix + ASCII",
+       [](unsigned n) {
+         return u8"議事録" + std::to_string(n % 100000) + ".pdf";
+       }},
+  };
+  std::mt19937 random(9660);
+  char converted[128 * utility::MAX_UTF8_PER_UCS2];
+  for (const Names& kind : kinds) {
+    const auto names = joliet_names(kind, count, &random);
+    const double alone = time(names, [&converted](const std::string& name) {
+      return utility::ucs2_to_utf8(name.data(), name.size(), converted);
+    });
+    // A new arena for every run so that names are stored and not just found.
+    std::unique_ptr<iso9660::NameArena> arena;
+    std::size_t interned = 0;
+    const double stored = time(names, [&](const std::string& name) {
+      if (interned++ % names.size() == 0) arena.reset(new iso9660::NameArena);
+      return utility::from_ucs2(name, arena.get()).size();
+    });
+    std::cout << kind.kind << ": ucs2_to_utf8 " << alone
+              << " ns, from_ucs2 + intern " << stored << " ns per name\n";
+  }
+  std::cout << std::flush;
+  return 0;
+}
@@ -26,7 +26,6 @@
 #include <cstring>
 
 #include <algorithm>
-#include <fstream>
 #include <ios>
 #include <iostream>
 #include <iterator>
@@ -37,8 +36,16 @@
 #include "./include/iso9660.h"
 #include "./include/utility.h"
 
+namespace {
+
+const std::string needle = "rd.live.image";
+const std::string overlay_switch =
+    " rd.live.overlay=LABEL=OVERLAY:/persistent-overlay.img";
+
+}  // namespace
+
 std::streamsize add_overlay_switch_to_grub_on_fat_image(
-    std::fstream *iofile, const iso9660::File &fileinfo) {
+    std::iostream *iofile, const iso9660::File &fileinfo) {
   auto swap_byte_order = [](std::uint32_t num) {
     return (num >> 24) | ((num << 8) & 0x00ff0000) | ((num >> 8) & 0x0000ff00) |
            (num << 24);
@@ -83,9 +90,8 @@ std::streamsize add_overlay_switch_to_grub_on_fat_image(
     if (std::strncmp(buffer, grub_signature,
                      std::extent<decltype(grub_signature)>::value - 1) == 0) {
       file.seekg(-SECTOR_SIZE, std::ios::cur);
-      iso9660::File fileinfo;
-      fileinfo.size = filesize;
-      filesize += insert_overlay_switch(iofile, fileinfo);
+      filesize += insert_overlay_switch_within(
+          iofile, filesize, iso9660::File::sector_align(filesize) - filesize);
       break;
     }
   }
@@ -100,7 +106,7 @@ std::streamsize add_overlay_switch_to_grub_on_fat_image(
 }
 
 std::streamsize add_overlay_switch_to_grub_on_hfsplus_image(
-    std::fstream *iofile, const iso9660::File &fileinfo) {
+    std::iostream *iofile, const iso9660::File &fileinfo) {
   auto swap_byte_order = [](std::uint32_t num) {
     return (num >> 24) | ((num << 8) & 0x00ff0000) | ((num >> 8) & 0x0000ff00) |
            (num << 24);
@@ -159,9 +165,10 @@ std::streamsize add_overlay_switch_to_grub_on_hfsplus_image(
     if (std::strncmp(buffer, grub_signature,
                      std::extent<decltype(grub_signature)>::value - 1) == 0) {
       file.seekg(-SECTOR_SIZE, std::ios::cur);
-      iso9660::File fileinfo;
-      fileinfo.size = filesize[file_index];
-      filesize[file_index] += insert_overlay_switch(iofile, fileinfo);
+      filesize[file_index] += insert_overlay_switch_within(
+          iofile, filesize[file_index],
+          iso9660::File::sector_align(filesize[file_index]) -
+              filesize[file_index]);
       if (file_index < NUM_FILES - 1) {
         // Make sure we're aligned for the next grub.cfg signature search.
         file.seekg(sector_align(file.tellg()));
@@ -184,14 +191,17 @@ std::streamsize add_overlay_switch_to_grub_on_hfsplus_image(
   return 0;
 }
 
-std::streamsize insert_overlay_switch(std::fstream *iofile,
+std::streamsize insert_overlay_switch(std::iostream *iofile,
                                       const iso9660::File &fileinfo) {
+  return insert_overlay_switch_within(iofile, fileinfo.size(),
+                                      fileinfo.max_growth());
+}
+
+std::streamsize insert_overlay_switch_within(std::iostream *iofile,
+                                             std::size_t size,
+                                             std::size_t max_growth) {
   auto &file = *iofile;
-  const std::string needle = "rd.live.image";
-  const std::string overlay_switch =
-      " rd.live.overlay=LABEL=OVERLAY:/persistent-overlay.img";
-  const std::size_t max_growth = fileinfo.max_growth();
-  std::cout << "File has a size of " << fileinfo.size
+  std::cout << "File has a size of " << size
             << " bytes and can grow by " << max_growth << " bytes.\n"
             << std::flush;
   /*
@@ -208,10 +218,10 @@ std::streamsize insert_overlay_switch(std::fstream *iofile,
   for (std::string line; std::getline(file, line);) {
     line += '\n';
     read_bytes += line.size();
-    if (read_bytes > fileinfo.size) {
+    if (read_bytes > size) {
       throw iso9660::CorruptFileException("Unexpected end of file at byte " +
                                           std::to_string(read_bytes) + " of " +
-                                          std::to_string(fileinfo.size) + ".");
+                                          std::to_string(size) + ".");
     }
     const auto position = line.find(needle);
     if (position != std::string::npos) {
@@ -227,7 +237,7 @@ std::streamsize insert_overlay_switch(std::fstream *iofile,
       if (insert_position == 0) {
         insert_position = file.tellg();
         insert_position -= line_size - line_offset;
-        file_content.reserve((fileinfo.size + max_growth) - read_bytes);
+        file_content.reserve((size + max_growth) - read_bytes);
         std::move(line.begin() + line_offset, line.end(),
                   std::back_inserter(file_content));
       } else {
@@ -236,7 +246,7 @@ std::streamsize insert_overlay_switch(std::fstream *iofile,
     } else if (insert_position != 0) {
       std::move(line.begin(), line.end(), std::back_inserter(file_content));
     }
-    if (read_bytes == fileinfo.size) break;
+    if (read_bytes == size) break;
   }
   file.clear();
   file.seekp(insert_position);
@@ -245,3 +255,28 @@ std::streamsize insert_overlay_switch(std::fstream *iofile,
             << std::flush;
   return growth;
 }
+
+/**
+ * The file is scanned in large chunks and only the current line is kept.
+ */
+std::size_t overlay_switch_growth(iso9660::FileReader *reader) {
+  std::size_t growth = 0;
+  std::string line;
+  std::vector<iso9660::Byte> chunk(16 * iso9660::SECTOR_SIZE);
+  for (std::uint64_t offset = 0; offset < reader->size();) {
+    const std::size_t count = reader->read(offset, chunk.size(), chunk.data());
+    offset += count;
+    for (std::size_t i = 0; i < count; ++i) {
+      if (chunk[i] != '\n') {
+        line += static_cast<char>(chunk[i]);
+        continue;
+      }
+      if (line.find(needle) != std::string::npos) {
+        growth += overlay_switch.size();
+      }
+      line.clear();
+    }
+  }
+  if (line.find(needle) != std::string::npos) growth += overlay_switch.size();
+  return growth;
+}
@@ -17,7 +17,8 @@
  * USA.
  */
 
-#include <fstream>
+#include <cstddef>
+#include <istream>
 #include <ios>
 
 #include "./include/iso9660.h"
@@ -26,10 +27,23 @@
  * Note: A better name for this would be much appreciated.
  */
 std::streamsize add_overlay_switch_to_grub_on_fat_image(
-    std::fstream* iofile, const iso9660::File& fileinfo);
+    std::iostream* iofile, const iso9660::File& fileinfo);
 
 std::streamsize add_overlay_switch_to_grub_on_hfsplus_image(
-    std::fstream* iofile, const iso9660::File& fileinfo);
+    std::iostream* iofile, const iso9660::File& fileinfo);
 
-std::streamsize insert_overlay_switch(std::fstream* iofile,
+std::streamsize insert_overlay_switch(std::iostream* iofile,
                                       const iso9660::File& fileinfo);
+
+/**
+ * Insert the overlay switches into a file of the given size that may grow by
+ * at most max_growth bytes.
+ */
+std::streamsize insert_overlay_switch_within(std::iostream* iofile,
+                                             std::size_t size,
+                                             std::size_t max_growth);
+
+/**
+ * By how many bytes a file grows if the overlay switches are inserted.
+ */
+std::size_t overlay_switch_growth(iso9660::FileReader* reader);
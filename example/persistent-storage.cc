@@ -42,7 +42,7 @@ int main(int argc, const char* argv[]) {
   constexpr const char* const configfiles[] = {"isolinux.cfg", "grub.cfg",
                                                "grub.conf"};
   for (const char* const configfile : configfiles) {
-    add_overlay(&isoimage, configfile, insert_overlay_switch);
+    add_overlay_to_config(&isoimage, configfile);
   }
   add_overlay(&isoimage, "efiboot.img",
               add_overlay_switch_to_grub_on_fat_image);
@@ -17,6 +17,7 @@
  * USA.
  */
 
+#include <cstddef>
 #include <iostream>
 #include <string>
 
@@ -28,9 +29,36 @@ template <class F>
 static void add_overlay(iso9660::Image* const isoimage,
                         const std::string& filename, F func) {
   auto file = isoimage->find(filename);
-  if (file == nullptr) {
+  if (!file) {
     std::cout << "Can't find " + filename + ". Skipping..\n" << std::flush;
     return;
   }
-  isoimage->modify_file(*file, func);
+  isoimage->modify_file(file, [func](iso9660::FileStream* stream,
+                                     const iso9660::File& fileinfo) {
+    func(stream, fileinfo);
+  });
+}
+
+/**
+ * Configuration files are moved if the overlay switches don't fit into their
+ * last sector.
+ */
+static void add_overlay_to_config(iso9660::Image* const isoimage,
+                                  const std::string& filename) {
+  auto file = isoimage->find(filename);
+  if (!file) {
+    std::cout << "Can't find " + filename + ". Skipping..\n" << std::flush;
+    return;
+  }
+  auto reader = isoimage->reader(file);
+  const std::size_t growth = overlay_switch_growth(&reader);
+  if (isoimage->relocate_file(file, file.size() + growth)) {
+    std::cout << "Moved " + filename + " to make room for "
+              << growth << " bytes.\n" << std::flush;
+  }
+  isoimage->modify_file(file, [](iso9660::FileStream* stream,
+                                 const iso9660::File& fileinfo) {
+    insert_overlay_switch_within(stream, fileinfo.size(),
+                                 stream->capacity() - fileinfo.size());
+  });
 }
@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef ISO9660_BLOCK_DEVICE_H_
+#define ISO9660_BLOCK_DEVICE_H_
+
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+
+#include "./include/buffer.h"
+
+namespace iso9660 {
+
+/**
+ * What is done to make sure that written data survives a crash or a power
+ * loss once it has been committed.
+ */
+enum class Durability {
+  // Leave it to the operating system when the data reaches the device.
+  NONE,
+  // Wait until the data but not necessarily all metadata reached the device.
+  DATA,
+  // Wait until the data and all metadata reached the device.
+  FULL
+};
+
+/**
+ * How a section of the image is about to be read. Sources may pass this on to
+ * the operating system to tune its read-ahead.
+ */
+enum class Access {
+  // Read front to back, so reading ahead aggressively pays off.
+  SEQUENTIAL,
+  // Read soon, so it may already be fetched in the background.
+  SOON
+};
+
+/**
+ * Positional read access to an image.
+ *
+ * There's no shared seek pointer so a source can be read from several threads
+ * at once.
+ */
+class EXPORT BlockSource {
+ public:
+  virtual ~BlockSource();
+  /**
+   * Read exactly size bytes starting at the byte offset into destination.
+   */
+  virtual void read(std::uint64_t offset, std::size_t size,
+                    iso9660::Byte* destination) const = 0;
+  /**
+   * Sources that keep the entire image in memory return a view into that
+   * memory so that nothing has to be copied. All other sources return an empty
+   * span.
+   */
+  virtual iso9660::Span view(std::uint64_t offset, std::size_t size) const;
+  /**
+   * Copy size bytes starting at the byte offset to a file descriptor at its
+   * current offset without passing them through user space.
+   *
+   * @return How many bytes have been copied. Sources that can't do this copy
+   * nothing by default, so the caller copies the rest.
+   */
+  virtual std::size_t transfer(std::uint64_t offset, std::size_t size,
+                               int fd) const;
+  /**
+   * Tell the source how a section is about to be read. This is only a hint
+   * which is ignored by default.
+   */
+  virtual void advise(std::uint64_t offset, std::size_t size,
+                      iso9660::Access access) const;
+  virtual std::uint64_t size() const = 0;
+  /**
+   * Changes whenever what's read from the source may have changed, so that
+   * readers know when to drop what they've kept. Sources that aren't written
+   * through, or can't tell, never change it by default.
+   */
+  virtual std::uint64_t generation() const;
+  void read_sectors(std::size_t location, std::size_t count,
+                    iso9660::Byte* destination) const;
+};
+
+/**
+ * Positional write access to an image.
+ */
+class EXPORT BlockSink {
+ public:
+  virtual ~BlockSink();
+  virtual void write(std::uint64_t offset, const iso9660::Byte* source,
+                     std::size_t size) = 0;
+  /**
+   * Write the given spans one after another starting at the byte offset. By
+   * default each span is written on its own.
+   */
+  virtual void write_vectored(std::uint64_t offset,
+                              const iso9660::Span* spans, std::size_t count);
+  /**
+   * Wait until everything that has been written so far is stored as durably
+   * as requested. Does nothing by default.
+   */
+  virtual void sync(iso9660::Durability durability);
+  /**
+   * Number of bytes the sink can hold. Sinks that grow as they're written
+   * past their end, e.g. regular files, are unlimited by default.
+   */
+  virtual std::uint64_t capacity() const;
+  void write_sectors(std::size_t location, std::size_t count,
+                     const iso9660::Byte* source);
+};
+
+/**
+ * Uses pread and pwrite on a file descriptor which may also refer to a block
+ * device. The file descriptor is not owned.
+ */
+class EXPORT FileDescriptorDevice : public BlockSource, public BlockSink {
+ public:
+  explicit FileDescriptorDevice(int fd);
+  void read(std::uint64_t offset, std::size_t size,
+            iso9660::Byte* destination) const override;
+  std::size_t transfer(std::uint64_t offset, std::size_t size,
+                       int fd) const override;
+  void advise(std::uint64_t offset, std::size_t size,
+              iso9660::Access access) const override;
+  std::uint64_t size() const override;
+  void write(std::uint64_t offset, const iso9660::Byte* source,
+             std::size_t size) override;
+  void write_vectored(std::uint64_t offset, const iso9660::Span* spans,
+                      std::size_t count) override;
+  void sync(iso9660::Durability durability) override;
+  // Block devices can't grow.
+  std::uint64_t capacity() const override;
+
+ private:
+  int fd_;
+};
+
+/**
+ * An image that lives in memory. The memory is not owned.
+ */
+class EXPORT MemoryDevice : public BlockSource, public BlockSink {
+ public:
+  MemoryDevice(iso9660::Byte* data, std::size_t size);
+  // Writing to a device that has been constructed like this throws.
+  MemoryDevice(const iso9660::Byte* data, std::size_t size);
+  void read(std::uint64_t offset, std::size_t size,
+            iso9660::Byte* destination) const override;
+  iso9660::Span view(std::uint64_t offset, std::size_t size) const override;
+  std::uint64_t size() const override;
+  void write(std::uint64_t offset, const iso9660::Byte* source,
+             std::size_t size) override;
+  std::uint64_t capacity() const override;
+
+ private:
+  const iso9660::Byte* data_;
+  iso9660::Byte* writable_;
+  std::size_t size_;
+};
+
+/**
+ * Adapter for iostreams. Since a stream only has a single seek pointer every
+ * access is serialized.
+ */
+class EXPORT StreamDevice : public BlockSource, public BlockSink {
+ public:
+  explicit StreamDevice(std::iostream* stream);
+  void read(std::uint64_t offset, std::size_t size,
+            iso9660::Byte* destination) const override;
+  std::uint64_t size() const override;
+  void write(std::uint64_t offset, const iso9660::Byte* source,
+             std::size_t size) override;
+  // Streams can only be flushed. The data is as durable as the stream makes it.
+  void sync(iso9660::Durability durability) override;
+
+ private:
+  std::iostream& stream_;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace iso9660
+
+#endif  // ISO9660_BLOCK_DEVICE_H_
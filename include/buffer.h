@@ -21,6 +21,7 @@
 #define ISO9660_BUFFER_H_
 
 #include <array>
+#include <cstddef>
 #include <utility>
 
 #define EXPORT __attribute__ ((visibility ("default")))
@@ -30,7 +31,41 @@ namespace iso9660 {
 constexpr std::size_t SECTOR_SIZE = 2048;
 constexpr std::size_t NUM_SYSTEM_SECTORS = 16;
 constexpr std::size_t SYSTEM_AREA_SIZE = NUM_SYSTEM_SECTORS * SECTOR_SIZE;
-using Buffer = std::array<unsigned char, iso9660::SECTOR_SIZE>;
+using Byte = unsigned char;
+using Buffer = std::array<Byte, iso9660::SECTOR_SIZE>;
+
+/**
+ * Read-only view over contiguous image data. It either points into a Buffer
+ * or straight into a memory mapping of the whole image so that records can be
+ * parsed without copying them first.
+ */
+class Span {
+ public:
+  using const_iterator = const Byte*;
+
+  constexpr Span() : first_(nullptr), last_(nullptr) {}
+  constexpr Span(const_iterator first, const_iterator last)
+      : first_(first), last_(last) {}
+  constexpr Span(const_iterator first, std::size_t size)
+      : first_(first), last_(first + size) {}
+  constexpr const_iterator begin() const { return first_; }
+  constexpr const_iterator end() const { return last_; }
+  constexpr std::size_t size() const {
+    return static_cast<std::size_t>(last_ - first_);
+  }
+  constexpr bool empty() const { return first_ == last_; }
+  constexpr Byte operator[](std::size_t index) const { return first_[index]; }
+  /**
+   * The caller has to make sure that the subspan lies within this span.
+   */
+  constexpr Span subspan(std::size_t offset, std::size_t size) const {
+    return Span(first_ + offset, size);
+  }
+
+ private:
+  const_iterator first_;
+  const_iterator last_;
+};
 
 }  // namespace iso9660
 
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef ISO9660_DIRECTORY_EXTENT_H_
+#define ISO9660_DIRECTORY_EXTENT_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "./include/buffer.h"
+#include "./include/string-view.h"
+
+namespace iso9660 {
+
+/**
+ * The directory records of a directory extent in a form that can be edited.
+ *
+ * Records are kept in the order of ECMA-119 9.3, i.e. the directory itself and
+ * its parent come first and all other records are ordered by their identifier.
+ * When written back they are packed so that no record crosses a sector
+ * boundary.
+ */
+class DirectoryExtent {
+ public:
+  // Position of the extent on the image in bytes.
+  DirectoryExtent(iso9660::Span extent, std::uint64_t position);
+  bool remove(std::uint64_t position);
+  void insert(std::vector<iso9660::Byte> record);
+  bool contains(iso9660::StringView identifier) const;
+  // Pad the result to at least the given size.
+  std::vector<iso9660::Byte> pack(std::size_t min_size) const;
+
+ private:
+  static iso9660::StringView identifier(
+      const std::vector<iso9660::Byte>& record);
+
+  std::vector<std::vector<iso9660::Byte>> records_;
+  // Where each record has been read from. Inserted records have none.
+  std::vector<std::uint64_t> positions_;
+};
+
+}  // namespace iso9660
+
+#endif  // ISO9660_DIRECTORY_EXTENT_H_
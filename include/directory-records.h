@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef ISO9660_DIRECTORY_RECORDS_H_
+#define ISO9660_DIRECTORY_RECORDS_H_
+
+#include <cstddef>
+#include <iterator>
+
+#include "./include/buffer.h"
+
+namespace iso9660 {
+
+/**
+ * Walks all directory records of a directory extent.
+ *
+ * According to ECMA-119 6.8.1.1 a directory record never crosses a sector
+ * boundary. Instead the remainder of the sector is padded with zeros and the
+ * next record starts at the beginning of the following sector.
+ */
+class DirectoryRecords {
+ public:
+  class iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = iso9660::Span;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const iso9660::Span*;
+    using reference = iso9660::Span;
+
+    iso9660::Span operator*() const;
+    iterator& operator++();
+    bool operator==(const iterator& other) const;
+    bool operator!=(const iterator& other) const;
+    // Position of the current record relative to the start of the extent.
+    std::size_t offset() const;
+
+   private:
+    friend class DirectoryRecords;
+    iterator(iso9660::Span extent, std::size_t offset);
+    void skip_padding();
+
+    iso9660::Span extent_;
+    std::size_t offset_;
+  };
+
+  explicit DirectoryRecords(iso9660::Span extent);
+  iterator begin() const;
+  iterator end() const;
+
+ private:
+  iso9660::Span extent_;
+};
+
+}  // namespace iso9660
+
+#endif  // ISO9660_DIRECTORY_RECORDS_H_
@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+/**
+ * Values as recorded according to ECMA-119. Every encoding knows its size and
+ * how to read and write a value of it. The bytes of numerical values are
+ * combined with shifts which compilers turn into a single load that's byte
+ * swapped if the host uses the other byte order.
+ */
+
+#ifndef ISO9660_ENCODING_H_
+#define ISO9660_ENCODING_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "./include/buffer.h"
+#include "./include/string-view.h"
+#include "./include/utility.h"
+
+namespace iso9660 {
+namespace encoding {
+
+/**
+ * ECMA-119 7.1.1: 8-bit unsigned numerical value.
+ */
+struct Uint8 {
+  using type = std::uint8_t;
+  static constexpr std::size_t SIZE = 1;
+
+  static constexpr type read(const iso9660::Byte* first) { return first[0]; }
+  static void write(iso9660::Byte* const first, type value) {
+    first[0] = value;
+  }
+  static constexpr bool consistent(const iso9660::Byte*) { return true; }
+};
+
+/**
+ * ECMA-119 7.1.2: 8-bit signed numerical value.
+ */
+struct Int8 {
+  using type = std::int8_t;
+  static constexpr std::size_t SIZE = 1;
+
+  static constexpr type read(const iso9660::Byte* first) {
+    return static_cast<type>(first[0]);
+  }
+  static void write(iso9660::Byte* const first, type value) {
+    first[0] = static_cast<iso9660::Byte>(value);
+  }
+  static constexpr bool consistent(const iso9660::Byte*) { return true; }
+};
+
+/**
+ * ECMA-119 7.2.1: 16-bit numerical value, least significant byte first.
+ */
+struct Uint16LE {
+  using type = std::uint16_t;
+  static constexpr std::size_t SIZE = 2;
+
+  static constexpr type read(const iso9660::Byte* first) {
+    return static_cast<type>(first[0] | first[1] << 8);
+  }
+  static void write(iso9660::Byte* const first, type value) {
+    first[0] = value & 0xff;
+    first[1] = value >> 8 & 0xff;
+  }
+  static constexpr bool consistent(const iso9660::Byte*) { return true; }
+};
+
+/**
+ * ECMA-119 7.2.2: 16-bit numerical value, most significant byte first.
+ */
+struct Uint16BE {
+  using type = std::uint16_t;
+  static constexpr std::size_t SIZE = 2;
+
+  static constexpr type read(const iso9660::Byte* first) {
+    return static_cast<type>(first[0] << 8 | first[1]);
+  }
+  static void write(iso9660::Byte* const first, type value) {
+    first[0] = value >> 8 & 0xff;
+    first[1] = value & 0xff;
+  }
+  static constexpr bool consistent(const iso9660::Byte*) { return true; }
+};
+
+/**
+ * ECMA-119 7.2.3: 16-bit numerical value recorded least significant byte
+ * first and then most significant byte first. The half in host byte order is
+ * read.
+ */
+struct Uint16Both {
+  using type = std::uint16_t;
+  static constexpr std::size_t SIZE = 4;
+
+  static constexpr type read(const iso9660::Byte* first) {
+    return ENDIANNESS == utility::Endian::LITTLE ? Uint16LE::read(first)
+                                                 : Uint16BE::read(first + 2);
+  }
+  static void write(iso9660::Byte* const first, type value) {
+    Uint16LE::write(first, value);
+    Uint16BE::write(first + 2, value);
+  }
+  static constexpr bool consistent(const iso9660::Byte* first) {
+    return Uint16LE::read(first) == Uint16BE::read(first + 2);
+  }
+};
+
+/**
+ * ECMA-119 7.3.1: 32-bit numerical value, least significant byte first.
+ */
+struct Uint32LE {
+  using type = std::uint32_t;
+  static constexpr std::size_t SIZE = 4;
+
+  static constexpr type read(const iso9660::Byte* first) {
+    return static_cast<type>(first[0]) | static_cast<type>(first[1]) << 8 |
+           static_cast<type>(first[2]) << 16 |
+           static_cast<type>(first[3]) << 24;
+  }
+  static void write(iso9660::Byte* const first, type value) {
+    first[0] = value & 0xff;
+    first[1] = value >> 8 & 0xff;
+    first[2] = value >> 16 & 0xff;
+    first[3] = value >> 24 & 0xff;
+  }
+  static constexpr bool consistent(const iso9660::Byte*) { return true; }
+};
+
+/**
+ * ECMA-119 7.3.2: 32-bit numerical value, most significant byte first.
+ */
+struct Uint32BE {
+  using type = std::uint32_t;
+  static constexpr std::size_t SIZE = 4;
+
+  static constexpr type read(const iso9660::Byte* first) {
+    return static_cast<type>(first[0]) << 24 |
+           static_cast<type>(first[1]) << 16 |
+           static_cast<type>(first[2]) << 8 | static_cast<type>(first[3]);
+  }
+  static void write(iso9660::Byte* const first, type value) {
+    first[0] = value >> 24 & 0xff;
+    first[1] = value >> 16 & 0xff;
+    first[2] = value >> 8 & 0xff;
+    first[3] = value & 0xff;
+  }
+  static constexpr bool consistent(const iso9660::Byte*) { return true; }
+};
+
+/**
+ * ECMA-119 7.3.3: 32-bit numerical value recorded least significant byte
+ * first and then most significant byte first. The half in host byte order is
+ * read.
+ */
+struct Uint32Both {
+  using type = std::uint32_t;
+  static constexpr std::size_t SIZE = 8;
+
+  static constexpr type read(const iso9660::Byte* first) {
+    return ENDIANNESS == utility::Endian::LITTLE ? Uint32LE::read(first)
+                                                 : Uint32BE::read(first + 4);
+  }
+  static void write(iso9660::Byte* const first, type value) {
+    Uint32LE::write(first, value);
+    Uint32BE::write(first + 4, value);
+  }
+  static constexpr bool consistent(const iso9660::Byte* first) {
+    return Uint32LE::read(first) == Uint32BE::read(first + 4);
+  }
+};
+
+/**
+ * ECMA-119 7.4: A fixed number of characters padded with spaces.
+ */
+template <std::size_t LENGTH>
+struct Characters {
+  using type = iso9660::StringView;
+  static constexpr std::size_t SIZE = LENGTH;
+
+  static type read(const iso9660::Byte* first) {
+    return type(reinterpret_cast<const char*>(first), SIZE);
+  }
+  static void write(iso9660::Byte* const first, type value) {
+    const std::size_t size = std::min(value.size(), SIZE);
+    std::copy(value.begin(), value.begin() + size, first);
+    std::fill(first + size, first + SIZE, ' ');
+  }
+  static constexpr bool consistent(const iso9660::Byte*) { return true; }
+};
+
+/**
+ * A fixed number of bytes that are interpreted elsewhere, e.g. the directory
+ * record of the root directory.
+ */
+template <std::size_t LENGTH>
+struct Bytes {
+  using type = iso9660::Span;
+  static constexpr std::size_t SIZE = LENGTH;
+
+  static constexpr type read(const iso9660::Byte* first) {
+    return type(first, SIZE);
+  }
+  static void write(iso9660::Byte* const first, type value) {
+    std::copy(value.begin(), value.begin() + std::min(value.size(), SIZE),
+              first);
+  }
+  static constexpr bool consistent(const iso9660::Byte*) { return true; }
+};
+
+/**
+ * ECMA-119 9.1.5: Date and time of a directory record in seconds since epoch.
+ */
+struct ShortDatetime {
+  using type = int;
+  static constexpr std::size_t SIZE = 7;
+
+  static type read(const iso9660::Byte* first);
+  static void write(iso9660::Byte* const first, type value);
+  static constexpr bool consistent(const iso9660::Byte*) { return true; }
+};
+
+/**
+ * ECMA-119 8.4.26.1: Date and time of a volume descriptor in milliseconds
+ * since epoch.
+ */
+struct LongDatetime {
+  using type = std::int64_t;
+  static constexpr std::size_t SIZE = 17;
+
+  static type read(const iso9660::Byte* first);
+  static void write(iso9660::Byte* const first, type value);
+  static constexpr bool consistent(const iso9660::Byte*) { return true; }
+};
+
+}  // namespace encoding
+}  // namespace iso9660
+
+#endif  // ISO9660_ENCODING_H_
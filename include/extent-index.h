@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef ISO9660_EXTENT_INDEX_H_
+#define ISO9660_EXTENT_INDEX_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "./include/buffer.h"
+#include "./include/file-table.h"
+
+namespace iso9660 {
+
+/**
+ * The extents of all files of a file table sorted by location. It's built at
+ * once after the directories have been read and kept in contiguous memory so
+ * that every query is a binary search. Files that are resized or moved
+ * afterwards are updated one at a time. An extent covers the sectors a file
+ * occupies, not the room a relocated file has been given to grow.
+ */
+class EXPORT ExtentIndex {
+ public:
+  struct Extent {
+    // First sector of the extent and the sector after the last one.
+    std::uint32_t first;
+    std::uint32_t last;
+    // Index of the file in the file table.
+    std::uint32_t file;
+  };
+  using const_iterator = std::vector<Extent>::const_iterator;
+
+  void build(const iso9660::FileTable& files);
+  void clear();
+  std::size_t size() const;
+  std::pair<const_iterator, const_iterator> at(std::size_t location) const;
+  std::vector<std::size_t> overlapping(std::size_t first,
+                                       std::size_t last) const;
+  void move(const iso9660::FileTable& files, std::size_t from,
+            std::size_t to);
+  void update(const iso9660::FileTable& files, std::size_t file);
+
+ private:
+  void update_reach(std::size_t first);
+
+  std::vector<Extent> extents_;
+  // The largest last sector of all extents up to and including each extent.
+  std::vector<std::uint32_t> reach_;
+};
+
+}  // namespace iso9660
+
+#endif  // ISO9660_EXTENT_INDEX_H_
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef ISO9660_FILE_READER_H_
+#define ISO9660_FILE_READER_H_
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "./include/block-device.h"
+#include "./include/buffer.h"
+#include "./include/file.h"
+
+namespace iso9660 {
+
+/**
+ * Positional read access to the content of a single file. Offsets are relative
+ * to the start of the file and reads end at the end of the file, even if it's
+ * recorded in several extents.
+ *
+ * A read that continues where the previous one ended is sequential. Sequential
+ * reads are served from a read-ahead window that doubles whenever it's refilled
+ * while the source is told to fetch the next window in the background. Any
+ * other read shrinks the window back to its minimum. The window points straight
+ * into the source if it provides views.
+ *
+ * Once the source tells that it has changed, e.g. because a modification of
+ * the image has been staged, the window is dropped and the extents of the file
+ * are looked up again. So the reader follows files that are resized or
+ * relocated. The file has to stay valid as long as the reader is used.
+ *
+ * A reader is meant to be used by a single thread at a time.
+ */
+class EXPORT FileReader {
+ public:
+  FileReader(const iso9660::BlockSource* source, const iso9660::File& file);
+  std::uint64_t size() const;
+  /**
+   * Read up to size bytes starting at the offset into destination.
+   *
+   * @return How many bytes have been read. Less than asked for only at the end
+   * of the file.
+   */
+  std::size_t read(std::uint64_t offset, std::size_t size,
+                   iso9660::Byte* destination);
+  // Number of bytes the next refill of the read-ahead window reads.
+  std::size_t window() const;
+
+ private:
+  void locate();
+  void fill(std::uint64_t offset);
+  void read_ahead(std::uint64_t offset);
+  void read_through(std::uint64_t offset, std::size_t size,
+                    iso9660::Byte* destination) const;
+  void advise(std::uint64_t offset, std::uint64_t size,
+              iso9660::Access access) const;
+  void split(std::uint64_t offset, std::uint64_t size,
+             const std::function<void(std::uint64_t, std::size_t)>& section)
+      const;
+
+  const iso9660::BlockSource* source_;
+  iso9660::File file_;
+  // Generation of the source the extents and the window belong to.
+  std::uint64_t generation_;
+  // Byte offset and size of each extent of the file on the image.
+  std::vector<std::pair<std::uint64_t, std::size_t>> sections_;
+  std::uint64_t size_;
+  std::vector<iso9660::Byte> buffer_;
+  // Position of the read-ahead window and what has been read into it.
+  std::uint64_t first_;
+  iso9660::Span filled_;
+  // Where a sequential read continues.
+  std::uint64_t next_;
+  // End of what the source has been asked to fetch in the background.
+  std::uint64_t advised_;
+  bool sequential_;
+  std::size_t window_;
+  // Whether the source provided a view of the window last time.
+  bool views_;
+};
+
+}  // namespace iso9660
+
+#endif  // ISO9660_FILE_READER_H_
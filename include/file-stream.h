@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef ISO9660_FILE_STREAM_H_
+#define ISO9660_FILE_STREAM_H_
+
+#include <cstdint>
+#include <istream>
+#include <streambuf>
+#include <vector>
+
+#include "./include/block-device.h"
+#include "./include/buffer.h"
+
+namespace iso9660 {
+
+/**
+ * Stream buffer over the content of a single file. Positions are relative to
+ * the start of the file and nothing beyond the extent of the file can be read
+ * or written.
+ *
+ * Reads beyond the size of the file hit the end of the file. Writes may go up
+ * to the capacity of the extent and make the file grow to cover them.
+ *
+ * Reads are served straight out of the source if it provides views. Reads and
+ * writes of at least the size of the internal buffer bypass it.
+ */
+class EXPORT FileBuffer : public std::streambuf {
+ public:
+  FileBuffer(const iso9660::BlockSource* source, iso9660::BlockSink* sink,
+             std::uint64_t offset, std::size_t size, std::size_t capacity);
+  FileBuffer(const FileBuffer&) = delete;
+  FileBuffer& operator=(const FileBuffer&) = delete;
+  std::size_t size() const;
+  std::size_t capacity() const;
+  void truncate(std::size_t size);
+
+ protected:
+  int_type underflow() override;
+  int_type overflow(int_type c) override;
+  int sync() override;
+  pos_type seekoff(off_type offset, std::ios_base::seekdir direction,
+                   std::ios_base::openmode which) override;
+  pos_type seekpos(pos_type position, std::ios_base::openmode which) override;
+  std::streamsize showmanyc() override;
+  std::streamsize xsgetn(char_type* destination,
+                         std::streamsize count) override;
+  std::streamsize xsputn(const char_type* source,
+                         std::streamsize count) override;
+
+ private:
+  std::size_t position() const;
+  void flush();
+
+  const iso9660::BlockSource* source_;
+  iso9660::BlockSink* sink_;
+  // Byte offset of the file on the image.
+  std::uint64_t offset_;
+  std::size_t size_;
+  std::size_t capacity_;
+  // Position of the start of the get or put area.
+  std::size_t first_;
+  // Position if there's neither a get nor a put area.
+  std::size_t position_;
+  std::vector<char_type> buffer_;
+};
+
+/**
+ * Stream over the content of a single file, see FileBuffer. Errors of the
+ * image are thrown instead of only setting the badbit.
+ */
+class EXPORT FileStream : public std::iostream {
+ public:
+  FileStream(const iso9660::BlockSource* source, iso9660::BlockSink* sink,
+             std::uint64_t offset, std::size_t size, std::size_t capacity);
+  /**
+   * Size of the file including everything that has been written so far.
+   */
+  std::size_t size() const;
+  /**
+   * Size the file can grow to without being relocated.
+   */
+  std::size_t capacity() const;
+  /**
+   * Cut the file off at the given size. Files can only grow by writing to
+   * them.
+   */
+  void truncate(std::size_t size);
+
+ private:
+  FileBuffer buffer_;
+};
+
+}  // namespace iso9660
+
+#endif  // ISO9660_FILE_STREAM_H_
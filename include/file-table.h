@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef ISO9660_FILE_TABLE_H_
+#define ISO9660_FILE_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "./include/buffer.h"
+#include "./include/file.h"
+#include "./include/name-arena.h"
+#include "./include/string-view.h"
+
+namespace iso9660 {
+
+/**
+ * The directory records of all directories of the image. Each field is stored
+ * in its own column so that operations on all files, e.g. summing up sizes or
+ * sorting by location, only walk through the memory they need. The files of a
+ * directory are stored consecutively.
+ */
+class EXPORT FileTable {
+ public:
+  std::vector<std::uint8_t> lengths;
+  // Bytes of the extended attribute record that precedes the data.
+  std::vector<std::uint32_t> extended_lengths;
+  std::vector<std::uint32_t> locations;
+  std::vector<std::uint32_t> sizes;
+  std::vector<std::int32_t> datetimes;
+  std::vector<std::uint8_t> flags;
+  std::vector<std::uint8_t> file_unit_sizes;
+  std::vector<std::uint8_t> interleave_gap_sizes;
+  std::vector<std::uint16_t> volume_sequence_numbers;
+  // Index of the directory in the path table the file has been found in.
+  std::vector<std::uint32_t> directories;
+  // Stored in the NameArena of the image.
+  std::vector<iso9660::StringView> names;
+  // Byte offset of the directory record on the image.
+  std::vector<std::uint64_t> positions;
+  /*
+   * A file is read from the Joliet volume descriptor if there's one. Its
+   * record in the primary volume descriptor is linked to it once all
+   * directories have been read. The position is zero until then and if
+   * there's no Joliet volume descriptor.
+   */
+  std::vector<std::uint64_t> primary_positions;
+  std::vector<iso9660::StringView> primary_names;
+
+  std::size_t size() const;
+  void reserve(std::size_t size);
+  std::size_t append(iso9660::Span record, iso9660::NameArena* const arena,
+                     std::size_t directory, bool joliet,
+                     std::uint64_t position);
+  void append(const FileTable& other, std::size_t first, std::size_t last);
+  void pop_back();
+  void link(const FileTable& primary,
+            const std::vector<std::size_t>& directories);
+  std::uint64_t total_size() const;
+  std::vector<std::size_t> by_location() const;
+
+  static std::size_t data_length(iso9660::Span record);
+  static void check_both_endian(iso9660::Span record);
+
+ private:
+  void link_by_name(const FileTable& primary,
+                    const std::vector<std::size_t>& files,
+                    const std::vector<std::size_t>& records);
+};
+
+}  // namespace iso9660
+
+#endif  // ISO9660_FILE_TABLE_H_
@@ -20,18 +20,27 @@
 #ifndef ISO9660_FILE_H_
 #define ISO9660_FILE_H_
 
-#include <string>
-#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 
 #include "./include/buffer.h"
+#include "./include/string-view.h"
 
 namespace iso9660 {
 
+class BlockSink;
+class FileTable;
+
 /**
  * ECMA-119 calls this a directory record but it's actually either a file or a
- * directory so it's a file.
+ * directory so it's a file. The information itself is stored in the file table
+ * of the image, this only refers to it and is cheap to copy.
+ *
+ * A file that is recorded in both the primary and the Joliet volume descriptor
+ * is a single file which knows both of its records.
  */
-class File {
+class EXPORT File {
  public:
   enum class Flag {
     /*
@@ -62,27 +71,74 @@ class File {
     MULTIPLE_RECORDS = 1 << 7
   };
 
-  std::size_t length;
-  std::size_t extended_length;
-  std::size_t location;
-  std::size_t size;
-  int datetime;
-  int flags;
-  int file_unit_size;
-  int interleave_gap_size;
-  int volume_sequence_number;
-  std::string name;
-
-  EXPORT File();
-  File(iso9660::Buffer::const_iterator first,
-       iso9660::Buffer::const_iterator last);
-  File(iso9660::Buffer::const_iterator first, std::size_t size);
+  File();
+  File(const iso9660::FileTable* table, std::size_t index);
+  std::size_t length() const;
+  std::size_t extended_length() const;
+  std::size_t location() const;
+  std::size_t size() const;
+  int datetime() const;
+  int flags() const;
+  int file_unit_size() const;
+  int interleave_gap_size() const;
+  int volume_sequence_number() const;
+  iso9660::StringView name() const;
+  iso9660::StringView primary_name() const;
+  std::uint64_t position() const;
+  std::uint64_t primary_position() const;
+  std::size_t directory() const;
+  std::size_t index() const;
   bool has(Flag flag) const;
   bool isdir() const;
-  EXPORT std::size_t max_growth() const;
+  std::size_t max_growth() const;
+  File next_extent() const;
+  void resize(iso9660::BlockSink* const sink, std::size_t size) const;
+  explicit operator bool() const;
 
- private:
   static std::size_t sector_align(std::size_t size);
+
+ private:
+  const iso9660::FileTable* table_;
+  std::size_t index_;
+};
+
+/**
+ * Consecutive files of the file table, e.g. the files of a directory.
+ */
+class EXPORT FileRange {
+ public:
+  class iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = iso9660::File;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const iso9660::File*;
+    using reference = iso9660::File;
+
+    iterator(const iso9660::FileTable* table, std::size_t index);
+    iso9660::File operator*() const;
+    iterator& operator++();
+    bool operator==(const iterator& other) const;
+    bool operator!=(const iterator& other) const;
+
+   private:
+    const iso9660::FileTable* table_;
+    std::size_t index_;
+  };
+
+  FileRange();
+  FileRange(const iso9660::FileTable* table, std::size_t first,
+            std::size_t last);
+  iterator begin() const;
+  iterator end() const;
+  std::size_t size() const;
+  bool empty() const;
+  iso9660::File operator[](std::size_t index) const;
+
+ private:
+  const iso9660::FileTable* table_;
+  std::size_t first_;
+  std::size_t last_;
 };
 
 }  // namespace iso9660
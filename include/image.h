@@ -17,16 +17,28 @@
  * USA.
  */
 
+#include <chrono>
+#include <cstdint>
 #include <fstream>
 #include <functional>
+#include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "./include/block-device.h"
 #include "./include/buffer.h"
+#include "./include/extent-index.h"
+#include "./include/file-reader.h"
+#include "./include/file-stream.h"
+#include "./include/file-table.h"
 #include "./include/file.h"
+#include "./include/journal.h"
+#include "./include/name-arena.h"
 #include "./include/path-table.h"
+#include "./include/string-view.h"
 #include "./include/volume-descriptor.h"
 
 #ifndef ISO9660_IMAGE_H_
@@ -34,6 +46,69 @@
 
 namespace iso9660 {
 
+struct ReadOptions {
+  /*
+   * Number of threads that read directories in parallel. Directories are read
+   * one after another if this is at most one.
+   */
+  std::size_t workers;
+  /*
+   * Only read the volume descriptors and path tables up front. The files of a
+   * directory are read as soon as a lookup or a listing needs them.
+   */
+  bool lazy;
+  /*
+   * Numerical values that are recorded in both byte orders are only read in
+   * the byte order of the host. Checking that the other half agrees detects
+   * corrupt records at the cost of one comparison per field.
+   */
+  bool check_both_endian;
+
+  ReadOptions() : workers(1), lazy(false), check_both_endian(false) {}
+};
+
+struct WriteOptions {
+  // How durably staged modifications are stored once they've been written.
+  iso9660::Durability durability;
+
+  WriteOptions() : durability(iso9660::Durability::NONE) {}
+};
+
+struct ExtractOptions {
+  /*
+   * Number of threads that extract files in parallel. Zero uses one thread per
+   * hardware thread.
+   */
+  std::size_t workers;
+  // Only the content of this directory is extracted, e.g. "/EFI/BOOT".
+  std::string directory;
+
+  ExtractOptions() : workers(0), directory("/") {}
+};
+
+struct ExtractStatistics {
+  std::size_t files;
+  // Directories that have been created beneath the destination.
+  std::size_t directories;
+  std::uint64_t bytes;
+  // Wall clock time of the whole extraction. Throughput is bytes / elapsed.
+  std::chrono::nanoseconds elapsed;
+  /*
+   * Latency of a file is the time from creating it until it has been closed.
+   * The mean latency is the total divided by the number of files.
+   */
+  std::chrono::nanoseconds total_latency;
+  std::chrono::nanoseconds max_latency;
+
+  ExtractStatistics()
+      : files(0),
+        directories(0),
+        bytes(0),
+        elapsed(0),
+        total_latency(0),
+        max_latency(0) {}
+};
+
 class Image {
  private:
   enum class Identifier {
@@ -49,32 +124,205 @@ class Image {
     UNKNOWN
   };
   static Identifier identifier_of(const std::string& identifier);
-  void read_directories(iso9660::PathTable* const path_table);
-  std::vector<iso9660::File> read_directory(std::size_t location);
+  // Byte offset and size of a section of the image.
+  using Section = std::pair<std::uint64_t, std::size_t>;
+  iso9660::Span read(std::size_t position, std::size_t size,
+                     std::vector<iso9660::Byte>* const buffer) const;
+  iso9660::Span read(std::size_t position, std::size_t size);
+  std::vector<Section> sections(const iso9660::File& file) const;
+  void read_section(
+      std::uint64_t offset, std::size_t size,
+      std::vector<iso9660::Byte>* const buffer,
+      const std::function<void(iso9660::Span)>& consume) const;
+  void read_directories(iso9660::PathTable* const path_table,
+                        std::size_t workers);
+  void read_all_directories();
+  void check_linked(const iso9660::File& file);
+  const iso9660::ExtentIndex& extent_index();
+  iso9660::VolumeDescriptor& lookup_volume();
+  iso9660::Directory* load_directory(iso9660::StringView path);
+  void read_directory(const iso9660::Directory& directory,
+                      std::size_t index, bool joliet,
+                      std::vector<iso9660::Byte>* const buffer,
+                      iso9660::FileTable* const files) const;
   void read_path_table(iso9660::VolumeDescriptor* const volume_descriptor);
-  iso9660::SectorType read_volume_descriptor();
+  iso9660::SectorType read_volume_descriptor(iso9660::Span descriptor,
+                                             std::size_t location);
+  bool resize_file(const iso9660::File& file, std::streamsize growth);
+  std::size_t volume_end() const;
+  std::size_t extent_capacity(const iso9660::File& file) const;
+  void copy_sectors(const iso9660::BlockSource& source, std::uint64_t offset,
+                    iso9660::BlockSink* const sink, std::size_t to,
+                    std::size_t size, std::size_t extent_size);
+  void check_room(std::size_t end) const;
+  static std::string record_identifier(const std::string& name, bool joliet);
+  // What's written to a volume descriptor when files are added or removed.
+  struct DirectoryEdit {
+    iso9660::VolumeDescriptor* volume;
+    // Content of the directory extents by their location.
+    std::map<std::size_t, std::vector<iso9660::Byte>> extents;
+    // Content of the path tables by their position.
+    std::map<std::uint64_t, std::vector<iso9660::Byte>> path_tables;
+    bool root_moved;
+    std::size_t root_location;
+    std::size_t root_size;
+  };
+  void edit_directories();
+  DirectoryEdit plan_directories(iso9660::VolumeDescriptor* const volume,
+                                 const std::vector<std::size_t>& locations,
+                                 std::size_t* const end);
+  std::size_t directory_size(std::size_t location);
+  static void refer_to_moved(
+      std::vector<iso9660::Byte>* const extent,
+      const std::unordered_map<std::size_t,
+                               std::pair<std::size_t, std::size_t>>& moved);
+  void reload();
 
  public:
   EXPORT explicit Image(std::fstream* file);
+  /**
+   * Read the image from any source, e.g. a memory mapping. Without a sink the
+   * image can't be modified.
+   */
+  EXPORT explicit Image(const iso9660::BlockSource* source,
+                        iso9660::BlockSink* sink = nullptr);
   EXPORT void read();
+  EXPORT void read(const iso9660::ReadOptions& options);
   EXPORT void write();
-  EXPORT const iso9660::File* find(const std::string& filename);
+  EXPORT void write(const iso9660::WriteOptions& options);
+  EXPORT iso9660::File find(const std::string& filename);
+  EXPORT const iso9660::FileRange* list(const std::string& path);
+  EXPORT const iso9660::FileTable& files() const;
+  EXPORT std::vector<iso9660::File> overlapping(std::size_t first,
+                                                std::size_t last);
+  /**
+   * Hand the content of a file to the callback in consecutive chunks. A file
+   * that is recorded in several extents is read as a whole. Chunks point
+   * straight into the image if the source provides views and are only valid
+   * during the call.
+   */
+  EXPORT void read_file(
+      const iso9660::File& file,
+      const std::function<void(iso9660::Span)>& consume) const;
+  /**
+   * Write the content of a file to a file descriptor at its current offset,
+   * e.g. to a regular file or a pipe. The kernel copies the data if the image
+   * is read through a file descriptor.
+   *
+   * @return Number of bytes that have been written.
+   */
+  EXPORT std::uint64_t extract(const iso9660::File& file, int fd) const;
+  /**
+   * Read a file at arbitrary offsets with read-ahead that adapts to how it's
+   * read. The reader sees modifications that haven't been written yet and is
+   * valid as long as the image.
+   */
+  EXPORT iso9660::FileReader reader(const iso9660::File& file) const;
+  /**
+   * Extract the files of a directory and all of its subdirectories to a
+   * directory on disk which is created if needed. Names lose their version
+   * number and existing files are overwritten.
+   */
+  EXPORT iso9660::ExtractStatistics extract_all(
+      const std::string& destination);
+  EXPORT iso9660::ExtractStatistics extract_all(
+      const std::string& destination, const iso9660::ExtractOptions& options);
   EXPORT bool modify_file(
       const iso9660::File& file,
       std::function<std::streamsize(std::fstream*, const iso9660::File&)>
           modify);
+  /**
+   * Same as above but the callback writes through a sink that stages the
+   * modification until the image is written.
+   */
+  EXPORT bool modify_file(
+      const iso9660::File& file,
+      std::function<std::streamsize(iso9660::BlockSink*, const iso9660::File&)>
+          modify);
+  /**
+   * The callback reads and writes the file through a stream that can't reach
+   * beyond the extent of the file. The file is resized to whatever the stream
+   * tells once the callback returns, so writing past the end makes it grow.
+   * Nothing reaches the image before it's written.
+   *
+   * @return Whether the size of the file has changed.
+   */
+  EXPORT bool modify_file(
+      const iso9660::File& file,
+      std::function<void(iso9660::FileStream*, const iso9660::File&)> modify);
+  /**
+   * Move the extent of a file to the end of the image if it's too small to
+   * hold the given number of bytes. Files that refer to the extent see the
+   * new location right away. The content is streamed to the end of the image
+   * at once. If the image isn't written afterwards, that's unused space.
+   *
+   * The image grows past the end of its sink. Image files and fstreams can
+   * grow. Block devices and MemoryDevices can't, so an exception is thrown
+   * before anything is modified. The same goes for adding files.
+   *
+   * @return Whether the file has been moved.
+   */
+  EXPORT bool relocate_file(const iso9660::File& file, std::size_t size);
+  /**
+   * Add a file to an existing directory, e.g. "/isolinux/ks.cfg". The content
+   * is only read when the image is written so it has to live until then. Its
+   * size is taken right away though and has to stay the same. The file is
+   * added to both volume descriptors. Files of 4 GiB or more can't be added.
+   *
+   * A path or name that can't be added to both volume descriptors throws
+   * here. If writing the image fails anyway, nothing is written.
+   *
+   * Writing the image reads it again so files that have been found before
+   * are invalid afterwards.
+   */
+  EXPORT void add_file(const std::string& path,
+                       const iso9660::BlockSource* content);
+  /**
+   * Remove a file from both volume descriptors when the image is written. Its
+   * extent isn't reused.
+   */
+  EXPORT void remove_file(const iso9660::File& file);
 
  private:
-  std::fstream& file_;
-  iso9660::Buffer buffer_;
+  // Only set if the image has been opened through an fstream.
+  std::fstream* file_;
+  std::unique_ptr<iso9660::StreamDevice> stream_;
+  const iso9660::BlockSource* source_;
+  iso9660::BlockSink* sink_;
+  // Modifications are staged here until the image is written.
+  iso9660::Journal journal_;
+  iso9660::ReadOptions options_;
+  // Holds whatever has been read last unless the source provides views.
+  std::vector<iso9660::Byte> buffer_;
+  /*
+   * Names of both volume descriptors. Has to outlive them. Directories are read
+   * concurrently which is fine since the arena is thread-safe.
+   */
+  mutable iso9660::NameArena names_;
+  // Files of all directories that have been read so far.
+  iso9660::FileTable files_;
   std::unique_ptr<iso9660::VolumeDescriptor> primary_;
   std::unique_ptr<iso9660::VolumeDescriptor> supplementary_;
-  /**
-   * In case only a minor change happened, i.e. the position of the file does
-   * not need to be changed. It's convenient to know where the file information
-   * is stored on the image.
-   */
-  std::unordered_map<std::size_t, std::vector<std::size_t>> file_positions_;
+  // Built once all directories have been read.
+  iso9660::ExtentIndex extents_;
+  // Size of the extents that files have been moved to by their location.
+  std::unordered_map<std::size_t, std::size_t> reserved_;
+  struct AddedFile {
+    std::string directory;
+    std::string name;
+    const iso9660::BlockSource* content;
+    // Told when the file is added.
+    std::size_t size;
+    // Index of the directory in the path table of each volume descriptor.
+    std::size_t primary_directory;
+    std::size_t supplementary_directory;
+
+    std::size_t directory_in(const iso9660::VolumeDescriptor& volume) const;
+  };
+  // Files that are added when the image is written.
+  std::vector<AddedFile> added_;
+  // Positions of the directory records that are removed.
+  std::vector<std::uint64_t> removed_;
 };
 
 }  // namespace iso9660
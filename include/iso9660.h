@@ -25,6 +25,11 @@
 #define ISO9660_ISO9660_H_
 
 #include "./include/image.h"
+#include "./include/block-device.h"
+#include "./include/mapped-file.h"
+#include "./include/sector-cache.h"
+#include "./include/file-stream.h"
+#include "./include/file-reader.h"
 #include "./include/file.h"
 #include "./include/exception.h"
 
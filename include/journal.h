@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef ISO9660_JOURNAL_H_
+#define ISO9660_JOURNAL_H_
+
+#include <array>
+#include <cstdint>
+#include <map>
+
+#include "./include/block-device.h"
+#include "./include/buffer.h"
+
+namespace iso9660 {
+
+/**
+ * Stages writes to an image in memory until they're committed.
+ *
+ * Writes are collected as whole dirty sectors. Small writes that hit the same
+ * sector, e.g. the directory records of neighbouring files, end up in a single
+ * sector. Staging a write never reads from the image. Instead it's remembered
+ * which bytes of a sector have been written and the rest of the sector is read
+ * on commit. On commit all dirty sectors are read and written in ascending
+ * order and adjacent sectors are read and written at once.
+ *
+ * Reads see the staged writes. They may happen concurrently as long as nothing
+ * is written at the same time.
+ */
+class EXPORT Journal : public BlockSource, public BlockSink {
+ public:
+  Journal(const iso9660::BlockSource* source, iso9660::BlockSink* sink);
+  void read(std::uint64_t offset, std::size_t size,
+            iso9660::Byte* destination) const override;
+  iso9660::Span view(std::uint64_t offset, std::size_t size) const override;
+  std::size_t transfer(std::uint64_t offset, std::size_t size,
+                       int fd) const override;
+  void advise(std::uint64_t offset, std::size_t size,
+              iso9660::Access access) const override;
+  std::uint64_t size() const override;
+  // Changes whenever a write is staged or discarded.
+  std::uint64_t generation() const override;
+  void write(std::uint64_t offset, const iso9660::Byte* source,
+             std::size_t size) override;
+  std::uint64_t capacity() const override;
+  void commit(iso9660::Durability durability);
+  // Only commit the dirty sectors that overlap the given section.
+  void commit(std::uint64_t offset, std::size_t size,
+              iso9660::Durability durability);
+  // Forget about everything that hasn't been committed yet.
+  void discard();
+  bool empty() const;
+  std::size_t dirty_sectors() const;
+
+ private:
+  struct Sector {
+    iso9660::Buffer data;
+    // One bit for each byte of data that has been written.
+    std::array<std::uint64_t, iso9660::SECTOR_SIZE / 64> written;
+
+    void mark(std::size_t first, std::size_t count);
+    bool complete() const;
+    void overlay(std::size_t first, std::size_t count,
+                 iso9660::Byte* destination) const;
+    void fill(const iso9660::Byte* original);
+  };
+  using Sectors = std::map<std::size_t, Sector>;
+  void write_sectors(Sectors::iterator first, Sectors::iterator last,
+                     iso9660::Durability durability);
+  void read_unwritten(Sectors::iterator first, Sectors::iterator last);
+  bool staged(std::uint64_t offset, std::size_t size) const;
+
+  const iso9660::BlockSource* source_;
+  iso9660::BlockSink* sink_;
+  // Dirty sectors by their location.
+  Sectors sectors_;
+  std::uint64_t generation_;
+};
+
+}  // namespace iso9660
+
+#endif  // ISO9660_JOURNAL_H_
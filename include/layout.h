@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+/**
+ * Layout of the records of ECMA-119. Each field knows where it's located
+ * within its record and how it's encoded, so reading and writing a field is
+ * done through the same description.
+ */
+
+#ifndef ISO9660_LAYOUT_H_
+#define ISO9660_LAYOUT_H_
+
+#include <cstddef>
+
+#include "./include/buffer.h"
+#include "./include/encoding.h"
+
+namespace iso9660 {
+namespace layout {
+
+template <std::size_t FIELD_OFFSET, class Encoding>
+struct Field {
+  using type = typename Encoding::type;
+  using encoding_type = Encoding;
+  static constexpr std::size_t OFFSET = FIELD_OFFSET;
+  static constexpr std::size_t SIZE = Encoding::SIZE;
+  // Offset of the first byte after the field.
+  static constexpr std::size_t END = OFFSET + SIZE;
+
+  static constexpr type read(const iso9660::Byte* record) {
+    return Encoding::read(record + OFFSET);
+  }
+  static void write(iso9660::Byte* const record, type value) {
+    Encoding::write(record + OFFSET, value);
+  }
+  static constexpr bool consistent(const iso9660::Byte* record) {
+    return Encoding::consistent(record + OFFSET);
+  }
+};
+
+/**
+ * ECMA-119 9.1: Directory record. The file identifier follows the fixed part.
+ */
+namespace directory_record {
+
+using Length = Field<0, encoding::Uint8>;
+using ExtendedAttributeLength = Field<1, encoding::Uint8>;
+using Location = Field<2, encoding::Uint32Both>;
+using DataLength = Field<10, encoding::Uint32Both>;
+using RecordingDatetime = Field<18, encoding::ShortDatetime>;
+using Flags = Field<25, encoding::Uint8>;
+using FileUnitSize = Field<26, encoding::Uint8>;
+using InterleaveGapSize = Field<27, encoding::Uint8>;
+using VolumeSequenceNumber = Field<28, encoding::Uint16Both>;
+using FileIdentifierLength = Field<32, encoding::Uint8>;
+constexpr std::size_t FILE_IDENTIFIER = FileIdentifierLength::END;
+// The fixed part and a file identifier of one byte.
+constexpr std::size_t MIN_SIZE = FILE_IDENTIFIER + 1;
+
+static_assert(DataLength::OFFSET == Location::END, "Fields must be adjacent.");
+static_assert(MIN_SIZE == 34, "ECMA-119 9.1");
+
+}  // namespace directory_record
+
+/**
+ * ECMA-119 9.4: Path table record. Only the path table that's recorded most
+ * significant byte first is read. The directory identifier follows the fixed
+ * part.
+ */
+namespace path_table_record {
+
+using DirectoryIdentifierLength = Field<0, encoding::Uint8>;
+using ExtendedAttributeLength = Field<1, encoding::Uint8>;
+using Location = Field<2, encoding::Uint32BE>;
+using Parent = Field<6, encoding::Uint16BE>;
+constexpr std::size_t DIRECTORY_IDENTIFIER = Parent::END;
+constexpr std::size_t MIN_SIZE = DIRECTORY_IDENTIFIER + 2;
+
+static_assert(DIRECTORY_IDENTIFIER == 8, "ECMA-119 9.4");
+
+}  // namespace path_table_record
+
+/**
+ * ECMA-119 8.1: Fields every volume descriptor starts with.
+ */
+namespace volume_descriptor_header {
+
+using Type = Field<0, encoding::Uint8>;
+using StandardIdentifier = Field<1, encoding::Characters<5>>;
+using Version = Field<6, encoding::Uint8>;
+
+}  // namespace volume_descriptor_header
+
+/**
+ * ECMA-119 8.4 and 8.5: Primary and supplementary volume descriptor. Volume
+ * flags and escape sequences are only used by the latter.
+ */
+namespace volume_descriptor {
+
+using VolumeFlags = Field<7, encoding::Uint8>;
+using SystemIdentifier = Field<8, encoding::Characters<32>>;
+using VolumeIdentifier = Field<40, encoding::Characters<32>>;
+using VolumeSpaceSize = Field<80, encoding::Uint32Both>;
+using EscapeSequences = Field<88, encoding::Characters<32>>;
+using VolumeSetSize = Field<120, encoding::Uint16Both>;
+using VolumeSequenceNumber = Field<124, encoding::Uint16Both>;
+using LogicalBlockSize = Field<128, encoding::Uint16Both>;
+using PathTableSize = Field<132, encoding::Uint32Both>;
+using TypeLPathTableLocation = Field<140, encoding::Uint32LE>;
+using OptionalTypeLPathTableLocation = Field<144, encoding::Uint32LE>;
+using TypeMPathTableLocation = Field<148, encoding::Uint32BE>;
+using OptionalTypeMPathTableLocation = Field<152, encoding::Uint32BE>;
+using RootDirectoryRecord = Field<156, encoding::Bytes<34>>;
+using VolumeSetIdentifier = Field<190, encoding::Characters<128>>;
+using PublisherIdentifier = Field<318, encoding::Characters<128>>;
+using DataPreparerIdentifier = Field<446, encoding::Characters<128>>;
+using ApplicationIdentifier = Field<574, encoding::Characters<128>>;
+using CopyrightFileIdentifier = Field<702, encoding::Characters<37>>;
+using AbstractFileIdentifier = Field<739, encoding::Characters<37>>;
+using BibliographicFileIdentifier = Field<776, encoding::Characters<37>>;
+using VolumeCreationDatetime = Field<813, encoding::LongDatetime>;
+using VolumeModificationDatetime = Field<830, encoding::LongDatetime>;
+using VolumeExpirationDatetime = Field<847, encoding::LongDatetime>;
+using VolumeEffectiveDatetime = Field<864, encoding::LongDatetime>;
+using FileStructureVersion = Field<881, encoding::Uint8>;
+using ApplicationUse = Field<883, encoding::Characters<512>>;
+
+static_assert(RootDirectoryRecord::SIZE == directory_record::MIN_SIZE,
+              "The root directory is identified by a single byte.");
+static_assert(VolumeSetIdentifier::OFFSET == RootDirectoryRecord::END,
+              "Fields must be adjacent.");
+static_assert(VolumeCreationDatetime::OFFSET ==
+                  BibliographicFileIdentifier::END,
+              "Fields must be adjacent.");
+static_assert(ApplicationUse::OFFSET == FileStructureVersion::END + 1,
+              "One reserved byte.");
+static_assert(ApplicationUse::END + 653 == iso9660::SECTOR_SIZE,
+              "ECMA-119 8.4");
+
+}  // namespace volume_descriptor
+}  // namespace layout
+}  // namespace iso9660
+
+#endif  // ISO9660_LAYOUT_H_
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef ISO9660_MAPPED_FILE_H_
+#define ISO9660_MAPPED_FILE_H_
+
+#include <cstdint>
+#include <string>
+
+#include "./include/block-device.h"
+#include "./include/buffer.h"
+
+namespace iso9660 {
+
+/**
+ * Read-only memory mapping of an entire image file.
+ *
+ * An image that is read through a mapping does not copy any sectors. All
+ * records are parsed straight out of the mapped pages.
+ */
+class EXPORT MappedFile : public BlockSource {
+ public:
+  explicit MappedFile(const std::string& path);
+  ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  void read(std::uint64_t offset, std::size_t size,
+            iso9660::Byte* destination) const override;
+  iso9660::Span view(std::uint64_t offset, std::size_t size) const override;
+  void advise(std::uint64_t offset, std::size_t size,
+              iso9660::Access access) const override;
+  std::uint64_t size() const override;
+
+ private:
+  const iso9660::Byte* data_;
+  std::size_t size_;
+};
+
+}  // namespace iso9660
+
+#endif  // ISO9660_MAPPED_FILE_H_
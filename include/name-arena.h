@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef ISO9660_NAME_ARENA_H_
+#define ISO9660_NAME_ARENA_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "./include/string-view.h"
+
+namespace iso9660 {
+
+/**
+ * Image-scoped storage for the names of files and directories.
+ *
+ * Every distinct name is stored exactly once, packed into large chunks. The
+ * views that are handed out stay valid as long as the arena lives so they can
+ * be shared by the records, the lookup indexes and both volume descriptors.
+ * It's safe to intern names from several threads at once.
+ */
+class NameArena {
+ public:
+  NameArena();
+  NameArena(const NameArena&) = delete;
+  NameArena& operator=(const NameArena&) = delete;
+  iso9660::StringView intern(iso9660::StringView name);
+  // Number of distinct names.
+  std::size_t size() const;
+  // Number of bytes used to store the names.
+  std::size_t bytes() const;
+
+ private:
+  std::uint32_t store(iso9660::StringView name);
+  iso9660::StringView view(std::uint32_t slot) const;
+  void grow();
+
+  std::vector<std::unique_ptr<char[]>> chunks_;
+  char* free_;
+  std::size_t available_;
+  std::size_t bytes_;
+  /*
+   * Open addressing with linear probing so that interning a name does not
+   * allocate anything but the name itself. A slot refers to a stored name by
+   * the index of its chunk and its offset within the chunk.
+   */
+  std::vector<std::uint32_t> slots_;
+  std::size_t size_;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace iso9660
+
+#endif  // ISO9660_NAME_ARENA_H_
@@ -21,11 +21,15 @@
 #define ISO9660_PATH_TABLE_H_
 
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
-#include "./include/file.h"
 #include "./include/buffer.h"
+#include "./include/file-table.h"
+#include "./include/file.h"
+#include "./include/name-arena.h"
+#include "./include/string-view.h"
 
 namespace iso9660 {
 
@@ -38,20 +42,43 @@ class Directory {
   std::size_t extended_length;
   std::size_t location;
   int parent;
-  std::string name;
-  std::vector<iso9660::File> files;
+  // Stored in the NameArena of the image.
+  iso9660::StringView name;
+  // Stored in the file table of the image.
+  iso9660::FileRange files;
+  // Set as soon as the files of the directory have been read.
+  bool loaded;
+  // Index of the subdirectories in the path table by name.
+  std::unordered_map<iso9660::StringView, std::size_t> subdirectories;
+
+  Directory(iso9660::Span record, iso9660::NameArena* const names,
+            bool joliet);
+  iso9660::File find(iso9660::StringView filename);
 
-  Directory(iso9660::Buffer::const_iterator first,
-            iso9660::Buffer::const_iterator last);
+ private:
+  // Index of files by name. Built on the first lookup.
+  std::unordered_map<iso9660::StringView, iso9660::File> filenames_;
 };
 
 class PathTable {
  public:
   std::vector<Directory> directories;
 
-  PathTable(iso9660::Buffer::const_iterator first,
-            iso9660::Buffer::const_iterator last);
-  void joliet();
+  PathTable(iso9660::Span table, iso9660::NameArena* const names,
+            bool joliet);
+  bool is_joliet() const;
+  std::size_t resolve(iso9660::StringView path);
+  std::vector<std::size_t> match(const PathTable& other) const;
+
+ private:
+  void build_index();
+  void match_children(const PathTable& other,
+                      const std::vector<std::size_t>& children,
+                      std::size_t first, std::size_t last,
+                      std::vector<std::size_t>* const matches) const;
+
+  bool joliet_;
+  bool indexed_;
 };
 
 }  // namespace iso9660
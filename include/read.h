@@ -25,6 +25,7 @@
 #ifndef ISO9660_READ_H_
 #define ISO9660_READ_H_
 
+#include <cstdint>
 #include <utility>
 
 #include "./include/buffer.h"
@@ -32,13 +33,13 @@
 namespace iso9660 {
 namespace read {
 
-std::int64_t long_datetime(iso9660::Buffer::const_iterator first,
-                           iso9660::Buffer::const_iterator last);
-std::int64_t long_datetime(iso9660::Buffer::const_iterator first,
+std::int64_t long_datetime(iso9660::Span::const_iterator first,
+                           iso9660::Span::const_iterator last);
+std::int64_t long_datetime(iso9660::Span::const_iterator first,
                            std::size_t size);
-int short_datetime(iso9660::Buffer::const_iterator first,
-                   iso9660::Buffer::const_iterator last);
-int short_datetime(iso9660::Buffer::const_iterator first, std::size_t size);
+int short_datetime(iso9660::Span::const_iterator first,
+                   iso9660::Span::const_iterator last);
+int short_datetime(iso9660::Span::const_iterator first, std::size_t size);
 
 }  // namespace read
 }  // namespace iso9660
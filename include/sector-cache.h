@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef ISO9660_SECTOR_CACHE_H_
+#define ISO9660_SECTOR_CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "./include/block-device.h"
+#include "./include/buffer.h"
+
+namespace iso9660 {
+
+/**
+ * Keeps recently read sectors of an image in memory, e.g. for a service that
+ * inspects the same images over and over again. Put it between an image and
+ * its device to serve the volume descriptors, path tables and directories from
+ * memory once they've been read.
+ *
+ * The cache is split into shards by sector number which are locked on their
+ * own so it can be read from several threads at once. Each shard evicts
+ * sectors using the CLOCK algorithm. Reads that would fill a large part of the
+ * cache, e.g. the content of large files, bypass it.
+ *
+ * Writes through the cache update the cached sectors. If the image is modified
+ * any other way the cache has to be cleared.
+ */
+class EXPORT SectorCache : public BlockSource, public BlockSink {
+ public:
+  /**
+   * The capacity is given in bytes. Without a sink the cache is read-only.
+   */
+  SectorCache(const iso9660::BlockSource* source, iso9660::BlockSink* sink,
+              std::size_t capacity, std::size_t shards = 16);
+  SectorCache(const SectorCache&) = delete;
+  SectorCache& operator=(const SectorCache&) = delete;
+  void read(std::uint64_t offset, std::size_t size,
+            iso9660::Byte* destination) const override;
+  iso9660::Span view(std::uint64_t offset, std::size_t size) const override;
+  std::size_t transfer(std::uint64_t offset, std::size_t size,
+                       int fd) const override;
+  void advise(std::uint64_t offset, std::size_t size,
+              iso9660::Access access) const override;
+  std::uint64_t size() const override;
+  void write(std::uint64_t offset, const iso9660::Byte* source,
+             std::size_t size) override;
+  void write_vectored(std::uint64_t offset, const iso9660::Span* spans,
+                      std::size_t count) override;
+  void sync(iso9660::Durability durability) override;
+  std::uint64_t capacity() const override;
+  // Forget about all cached sectors.
+  void clear();
+  // Number of sectors that have been read from the cache.
+  std::uint64_t hits() const;
+  // Number of sectors that had to be read from the source.
+  std::uint64_t misses() const;
+
+ private:
+  struct Shard {
+    std::mutex mutex;
+    // Slot of each cached sector by its number.
+    std::unordered_map<std::uint64_t, std::size_t> slots;
+    // Number of the sector in each slot.
+    std::vector<std::uint64_t> sectors;
+    // Whether a slot has been read since the clock hand passed it.
+    std::vector<bool> referenced;
+    std::vector<iso9660::Byte> data;
+    std::size_t used;
+    std::size_t hand;
+  };
+
+  Shard& shard(std::uint64_t sector) const;
+  bool lookup(std::uint64_t sector, iso9660::Byte* destination) const;
+  void insert(std::uint64_t sector, const iso9660::Byte* source) const;
+  void update(std::uint64_t offset, const iso9660::Byte* source,
+              std::size_t size);
+
+  const iso9660::BlockSource* source_;
+  iso9660::BlockSink* sink_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  // Larger reads bypass the cache.
+  std::size_t bypass_;
+  // Only whole sectors before the end of the image are cached.
+  std::atomic<std::uint64_t> end_;
+  mutable std::atomic<std::uint64_t> hits_;
+  mutable std::atomic<std::uint64_t> misses_;
+};
+
+}  // namespace iso9660
+
+#endif  // ISO9660_SECTOR_CACHE_H_
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef ISO9660_STRING_VIEW_H_
+#define ISO9660_STRING_VIEW_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <string>
+
+namespace iso9660 {
+
+/**
+ * Non-owning reference to a string. Names of files and directories are views
+ * into the NameArena of the image they belong to.
+ */
+class StringView {
+ public:
+  using const_iterator = const char*;
+
+  constexpr StringView() : data_(nullptr), size_(0) {}
+  constexpr StringView(const char* data, std::size_t size)
+      : data_(data), size_(size) {}
+  // Implicit so that lookups can be done with a std::string.
+  StringView(const std::string& string)
+      : data_(string.data()), size_(string.size()) {}
+  constexpr const char* data() const { return data_; }
+  constexpr std::size_t size() const { return size_; }
+  constexpr bool empty() const { return size_ == 0; }
+  constexpr const_iterator begin() const { return data_; }
+  constexpr const_iterator end() const { return data_ + size_; }
+  constexpr char operator[](std::size_t index) const { return data_[index]; }
+  std::string str() const { return std::string(data_, size_); }
+  StringView substr(std::size_t position, std::size_t size) const {
+    return StringView(data_ + position, size);
+  }
+
+ private:
+  const char* data_;
+  std::size_t size_;
+};
+
+inline bool operator==(iso9660::StringView lhs, iso9660::StringView rhs) {
+  return lhs.size() == rhs.size() &&
+         (lhs.size() == 0 ||
+          std::memcmp(lhs.data(), rhs.data(), lhs.size()) == 0);
+}
+
+inline bool operator!=(iso9660::StringView lhs, iso9660::StringView rhs) {
+  return !(lhs == rhs);
+}
+
+inline std::ostream& operator<<(std::ostream& stream,
+                                iso9660::StringView view) {
+  return stream.write(view.data(), view.size());
+}
+
+}  // namespace iso9660
+
+namespace std {
+
+/**
+ * FNV-1a since names are short.
+ */
+template <>
+struct hash<iso9660::StringView> {
+  std::size_t operator()(iso9660::StringView view) const {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (char c : view) {
+      hash ^= static_cast<unsigned char>(c);
+      hash *= 1099511628211ull;
+    }
+    return static_cast<std::size_t>(hash);
+  }
+};
+
+}  // namespace std
+
+#endif  // ISO9660_STRING_VIEW_H_
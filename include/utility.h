@@ -21,11 +21,12 @@
 #define ISO9660_UTILITY_H_
 
 #include <iterator>
-#include <numeric>
 #include <string>
 #include <utility>
 
 #include "./include/buffer.h"
+#include "./include/name-arena.h"
+#include "./include/string-view.h"
 
 namespace utility {
 
@@ -45,76 +46,22 @@ enum class Endian { BIG = 0, LITTLE = 1 };
 #define ENDIANNESS utility::Endian::LITTLE
 #endif
 
-void big_endian(std::string* const raw);
-std::string from_ucs2(const std::u16string& from);
-std::string from_ucs2(std::string&& raw);
-
-std::string substr(iso9660::Buffer::const_iterator first,
-                   iso9660::Buffer::const_iterator last, std::size_t at,
-                   std::size_t size = 0);
-
-template <class T>
-T integer(iso9660::Buffer::const_iterator first,
-          iso9660::Buffer::const_iterator last) {
-  constexpr std::size_t BITS_IN_BYTE = 8;
-  const std::size_t bytes = std::distance(first, last);
-  const std::size_t bits = (bytes - 1) * BITS_IN_BYTE;
-
-  std::size_t i = 0;
-  return std::accumulate(
-      first, last, static_cast<T>(0),
-      [&i, bits](T result, iso9660::Buffer::value_type byte) {
-        result |= static_cast<T>(byte) << (bits - i * BITS_IN_BYTE);
-        ++i;
-        return result;
-      });
-}
-
-template <std::size_t SIZE, Endian ENDIAN, class T>
-std::array<char, SIZE> integer(const T number) {
-  constexpr std::size_t BITS_IN_BYTE = 8;
-  constexpr std::size_t bits = (SIZE - 1) * BITS_IN_BYTE;
-  std::array<char, SIZE> result;
-  for (std::size_t i = 0; i < SIZE; ++i) {
-    if (ENDIAN == ENDIANNESS) {
-      result[i] = (number >> (bits - i * BITS_IN_BYTE)) & 0xff;
-    } else {
-      result[i] = (number >> (bits - (SIZE - i - 1) * BITS_IN_BYTE)) & 0xff;
-    }
-  }
-  return result;
-}
-
-template <class T>
-void integer(T* const number, iso9660::Buffer::const_iterator big_endian,
-             iso9660::Buffer::const_iterator little_endian, std::size_t size) {
-  if (ENDIANNESS == utility::Endian::LITTLE) {
-    *number = integer<T>(little_endian, little_endian + size);
-  } else {
-    *number = integer<T>(big_endian, big_endian + size);
-  }
-}
-
-/**
- * The caller has to guarantee that the passed characters store the number in
- * the users system endian.
+/*
+ * A UCS-2 character takes up to three bytes in UTF-8. A surrogate pair takes
+ * four bytes for two characters.
  */
-template <class T>
-void integer(T* const number, iso9660::Buffer::const_iterator first,
-             std::size_t size) {
-  *number = integer<T>(first, first + size);
-}
-
-iso9660::Buffer::value_type at(iso9660::Buffer::const_iterator first,
-                               iso9660::Buffer::const_iterator last,
-                               std::size_t index);
-
-template <class T>
-void at(iso9660::Buffer::const_iterator first,
-        iso9660::Buffer::const_iterator last, T* const result,
-        std::size_t index) {
-  *result = static_cast<T>(at(first, last, index));
-}
+constexpr std::size_t MAX_UTF8_PER_UCS2 = 3;
+
+std::size_t ucs2_to_utf8(const char* first, std::size_t size,
+                         char* const destination);
+iso9660::StringView from_ucs2(iso9660::StringView raw,
+                              iso9660::NameArena* const names);
+std::string to_ucs2(iso9660::StringView name);
+std::string to_d_characters(iso9660::StringView name, bool directory);
+std::string comparable_name(iso9660::StringView name);
+
+iso9660::StringView view(iso9660::Span::const_iterator first, std::size_t at,
+                         std::size_t size);
 
 }  // namespace utility
 
@@ -20,6 +20,7 @@
 #ifndef ISO9660_VOLUME_DESCRIPTOR_H_
 #define ISO9660_VOLUME_DESCRIPTOR_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -28,7 +29,10 @@
 
 #include "./include/file.h"
 #include "./include/buffer.h"
+#include "./include/file-table.h"
+#include "./include/name-arena.h"
 #include "./include/path-table.h"
+#include "./include/string-view.h"
 
 namespace iso9660 {
 
@@ -60,46 +64,83 @@ struct VolumeDescriptorHeader {
 /**
  * The "generic" ECMA-119 volume descriptor for the primary and supplementary
  * volume descriptor.
+ *
+ * Only what's needed to locate the path table and the root directory is read
+ * up front. The descriptor sector is retained and every other field is read
+ * from it on access. Identifiers are views into the retained sector.
  */
 class VolumeDescriptor {
  public:
   VolumeDescriptorHeader header;
-  // Only used in the supplementary volume descriptor.
-  int flags;
-  std::string system_identifier;
-  std::string volume_identifier;
-  std::size_t volume_space_size;
-  // Only used in the supplementary volume descriptor.
-  std::string escape_sequences;
-  std::size_t volume_sequence_number;
-  std::size_t logical_block_size;
-  std::size_t path_table_size;
-  std::size_t path_table_location;
-  std::size_t optional_path_table_location;
-  std::unique_ptr<iso9660::File> root_directory;
-  std::string volume_set_identifier;
-  std::string publisher_identifier;
-  std::string data_preparer_identifier;
-  std::string application_identifier;
-  std::string copyright_file_identifier;
-  std::string abstract_file_identifier;
-  std::string bibliographic_file_identifier;
-  std::int64_t volume_create_datetime;
-  std::int64_t volume_modify_datetime;
-  std::int64_t volume_expiration_datetime;
-  std::int64_t volume_effective_datetime;
-  int file_structure_version;
-  std::string application_use;
+  // Sector in which the descriptor is recorded.
+  std::size_t location;
+  // Holds the directory record of the root directory only.
+  iso9660::FileTable root_record;
+  iso9660::File root_directory;
   // The path table specifies the directory hierarchy.
   std::unique_ptr<iso9660::PathTable> path_table;
   // A lookup table that can be used to quickly find files.
-  std::unordered_multimap<std::string, const iso9660::File*> filenames;
+  std::unordered_multimap<iso9660::StringView, iso9660::File> filenames;
 
-  VolumeDescriptor(iso9660::Buffer::const_iterator first,
-                   iso9660::Buffer::const_iterator last,
-                   iso9660::VolumeDescriptorHeader generic_header);
+  VolumeDescriptor(iso9660::Span descriptor, std::size_t location,
+                   iso9660::VolumeDescriptorHeader generic_header,
+                   iso9660::NameArena* const names);
+  // The root directory refers to the root record of this instance.
+  VolumeDescriptor(const VolumeDescriptor&) = delete;
+  VolumeDescriptor& operator=(const VolumeDescriptor&) = delete;
   void build_file_lookup();
+  static void check_both_endian(iso9660::Span descriptor);
   int joliet_level() const;
+  // The retained descriptor including all modifications.
+  iso9660::Span sector() const;
+  void set_volume_space_size(std::size_t size);
+  void set_root_directory(std::size_t location, std::size_t size);
+
+  // Only used in the supplementary volume descriptor.
+  int flags() const;
+  iso9660::StringView system_identifier() const;
+  iso9660::StringView volume_identifier() const;
+  std::size_t volume_space_size() const;
+  // Only used in the supplementary volume descriptor.
+  iso9660::StringView escape_sequences() const;
+  std::size_t volume_set_size() const;
+  std::size_t volume_sequence_number() const;
+  std::size_t logical_block_size() const;
+  std::size_t path_table_size() const;
+  std::size_t type_l_path_table_location() const;
+  std::size_t optional_type_l_path_table_location() const;
+  /*
+   * As specified in 6.9.2 there're actually two path tables which store the
+   * same information but using different endianness. The one with the most
+   * significant byte first is used.
+   */
+  std::size_t path_table_location() const;
+  std::size_t optional_path_table_location() const;
+  iso9660::StringView volume_set_identifier() const;
+  iso9660::StringView publisher_identifier() const;
+  iso9660::StringView data_preparer_identifier() const;
+  iso9660::StringView application_identifier() const;
+  iso9660::StringView copyright_file_identifier() const;
+  iso9660::StringView abstract_file_identifier() const;
+  iso9660::StringView bibliographic_file_identifier() const;
+  std::int64_t volume_create_datetime() const;
+  std::int64_t volume_modify_datetime() const;
+  std::int64_t volume_expiration_datetime() const;
+  std::int64_t volume_effective_datetime() const;
+  int file_structure_version() const;
+  iso9660::StringView application_use() const;
+
+ private:
+  enum Datetime { CREATE, MODIFY, EXPIRATION, EFFECTIVE, NUM_DATETIMES };
+  template <class Field>
+  typename Field::type field() const;
+  template <class Field>
+  std::int64_t datetime(Datetime which) const;
+
+  iso9660::Buffer sector_;
+  // Datetimes are the only fields that are expensive to decode.
+  mutable std::int64_t datetimes_[NUM_DATETIMES];
+  mutable bool decoded_[NUM_DATETIMES];
 };
 
 }  // namespace iso9660
@@ -21,29 +21,38 @@
 #define ISO9660_WRITE_H_
 
 #include <algorithm>
-#include <ostream>
+#include <array>
+#include <cstdint>
 #include <utility>
+#include <vector>
 
-#include "./include/utility.h"
+#include "./include/block-device.h"
+#include "./include/buffer.h"
+#include "./include/layout.h"
+#include "./include/string-view.h"
 
 namespace iso9660 {
 namespace write {
 
+void long_datetime(std::int64_t datetime, iso9660::Byte* const first);
+void short_datetime(int datetime, iso9660::Byte* const first);
+std::vector<iso9660::Byte> directory_record(std::size_t location,
+                                            std::size_t size, int datetime,
+                                            int flags,
+                                            iso9660::StringView identifier);
+
 template <class ForwardIt>
-void resize_file(std::ostream* const file, ForwardIt first, ForwardIt last,
-                 std::size_t size) {
-  constexpr std::size_t DIRECTORY_RECORD_SIZE_OFFSET = 10;
-  const auto big_endian_size = utility::integer<4, utility::Endian::BIG>(size);
-  const auto little_endian_size =
-      utility::integer<4, utility::Endian::LITTLE>(size);
-  std::for_each(
-      first, last,
-      [file, &little_endian_size, &big_endian_size](std::size_t position) {
-        file->clear();
-        file->seekp(position + DIRECTORY_RECORD_SIZE_OFFSET);
-        file->write(big_endian_size.data(), big_endian_size.size());
-        file->write(little_endian_size.data(), little_endian_size.size());
-      });
+void resize_file(iso9660::BlockSink* const sink, ForwardIt first,
+                 ForwardIt last, std::size_t size) {
+  using Size = iso9660::layout::directory_record::DataLength;
+  // Both halves are next to each other so they're written at once.
+  std::array<iso9660::Byte, Size::SIZE> both_endian_size;
+  Size::encoding_type::write(both_endian_size.data(),
+                             static_cast<Size::type>(size));
+  std::for_each(first, last, [sink, &both_endian_size](std::size_t position) {
+    sink->write(position + Size::OFFSET, both_endian_size.data(),
+                both_endian_size.size());
+  });
 }
 
 }  // namespace write
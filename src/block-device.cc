@@ -0,0 +1,400 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "./include/block-device.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "./include/buffer.h"
+#include "./include/exception.h"
+
+namespace {
+
+void check_range(std::uint64_t offset, std::size_t size,
+                 std::uint64_t total) {
+  if (offset > total || size > total - offset) {
+    throw iso9660::CorruptFileException("Unexpected end of image at byte " +
+                                        std::to_string(offset) + ".");
+  }
+}
+
+}  // namespace
+
+iso9660::BlockSource::~BlockSource() {}
+
+iso9660::Span iso9660::BlockSource::view(std::uint64_t offset,
+                                         std::size_t size) const {
+  return iso9660::Span();
+}
+
+std::size_t iso9660::BlockSource::transfer(std::uint64_t offset,
+                                           std::size_t size, int fd) const {
+  return 0;
+}
+
+void iso9660::BlockSource::advise(std::uint64_t offset, std::size_t size,
+                                  iso9660::Access access) const {}
+
+std::uint64_t iso9660::BlockSource::generation() const { return 0; }
+
+void iso9660::BlockSource::read_sectors(std::size_t location,
+                                        std::size_t count,
+                                        iso9660::Byte* destination) const {
+  read(static_cast<std::uint64_t>(location) * iso9660::SECTOR_SIZE,
+       count * iso9660::SECTOR_SIZE, destination);
+}
+
+iso9660::BlockSink::~BlockSink() {}
+
+void iso9660::BlockSink::write_vectored(std::uint64_t offset,
+                                        const iso9660::Span* spans,
+                                        std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    write(offset, spans[i].begin(), spans[i].size());
+    offset += spans[i].size();
+  }
+}
+
+void iso9660::BlockSink::sync(iso9660::Durability durability) {}
+
+std::uint64_t iso9660::BlockSink::capacity() const {
+  return std::numeric_limits<std::uint64_t>::max();
+}
+
+void iso9660::BlockSink::write_sectors(std::size_t location,
+                                       std::size_t count,
+                                       const iso9660::Byte* source) {
+  write(static_cast<std::uint64_t>(location) * iso9660::SECTOR_SIZE, source,
+        count * iso9660::SECTOR_SIZE);
+}
+
+#ifndef _WIN32
+iso9660::FileDescriptorDevice::FileDescriptorDevice(int fd) : fd_(fd) {}
+
+void iso9660::FileDescriptorDevice::read(std::uint64_t offset,
+                                         std::size_t size,
+                                         iso9660::Byte* destination) const {
+  while (size > 0) {
+    const ssize_t result = pread(fd_, destination, size, offset);
+    if (result < 0) {
+      if (errno == EINTR) continue;
+      throw iso9660::Exception("Couldn't read at byte " +
+                               std::to_string(offset) + ": " +
+                               std::strerror(errno));
+    }
+    if (result == 0) {
+      throw iso9660::CorruptFileException("Unexpected end of image at byte " +
+                                          std::to_string(offset) + ".");
+    }
+    destination += result;
+    offset += result;
+    size -= result;
+  }
+}
+
+/**
+ * copy_file_range lets the file system share or copy the data without even
+ * reading it. It refuses some pairs of files, e.g. pipes or files on different
+ * file systems with older kernels, which sendfile still copies in the kernel.
+ */
+std::size_t iso9660::FileDescriptorDevice::transfer(std::uint64_t offset,
+                                                    std::size_t size,
+                                                    int fd) const {
+  std::size_t done = 0;
+#ifdef __linux__
+  bool range = true;
+  while (done < size) {
+    ssize_t result = -1;
+    if (range) {
+#ifdef SYS_copy_file_range
+      loff_t position = static_cast<loff_t>(offset + done);
+      result = syscall(SYS_copy_file_range, fd_, &position, fd, nullptr,
+                       size - done, 0);
+#else
+      errno = ENOSYS;
+#endif
+      if (result < 0 && errno != EINTR) {
+        range = false;
+        continue;
+      }
+    } else {
+      off_t position = static_cast<off_t>(offset + done);
+      result = sendfile(fd, fd_, &position, size - done);
+      // The caller copies whatever is left and reports errors.
+      if (result < 0 && errno != EINTR) break;
+    }
+    if (result == 0) break;
+    if (result > 0) done += static_cast<std::size_t>(result);
+  }
+#endif
+  return done;
+}
+
+/**
+ * Linux applies sequential advice to the whole file no matter the section. That
+ * only makes it read ahead further which doesn't hurt other readers.
+ */
+void iso9660::FileDescriptorDevice::advise(std::uint64_t offset,
+                                           std::size_t size,
+                                           iso9660::Access access) const {
+#ifdef POSIX_FADV_SEQUENTIAL
+  const int advice = access == iso9660::Access::SEQUENTIAL
+                         ? POSIX_FADV_SEQUENTIAL
+                         : POSIX_FADV_WILLNEED;
+  posix_fadvise(fd_, static_cast<off_t>(offset), static_cast<off_t>(size),
+                advice);
+#endif
+}
+
+std::uint64_t iso9660::FileDescriptorDevice::size() const {
+  struct stat status;
+  if (fstat(fd_, &status) != 0) {
+    throw iso9660::Exception(std::string("Couldn't stat image: ") +
+                             std::strerror(errno));
+  }
+#ifdef __linux__
+  if (S_ISBLK(status.st_mode)) {
+    std::uint64_t size = 0;
+    if (ioctl(fd_, BLKGETSIZE64, &size) != 0) {
+      throw iso9660::Exception(std::string("Couldn't get device size: ") +
+                               std::strerror(errno));
+    }
+    return size;
+  }
+#endif
+  return static_cast<std::uint64_t>(status.st_size);
+}
+
+void iso9660::FileDescriptorDevice::write(std::uint64_t offset,
+                                          const iso9660::Byte* source,
+                                          std::size_t size) {
+  while (size > 0) {
+    const ssize_t result = pwrite(fd_, source, size, offset);
+    if (result < 0) {
+      if (errno == EINTR) continue;
+      throw iso9660::Exception("Couldn't write at byte " +
+                               std::to_string(offset) + ": " +
+                               std::strerror(errno));
+    }
+    source += result;
+    offset += result;
+    size -= result;
+  }
+}
+
+/**
+ * Write the spans with as few pwritev calls as possible.
+ */
+void iso9660::FileDescriptorDevice::write_vectored(std::uint64_t offset,
+                                                   const iso9660::Span* spans,
+                                                   std::size_t count) {
+  std::vector<struct iovec> vectors(std::min<std::size_t>(count, IOV_MAX));
+  while (count > 0) {
+    const std::size_t batch = std::min(count, vectors.size());
+    for (std::size_t i = 0; i < batch; ++i) {
+      vectors[i].iov_base = const_cast<iso9660::Byte*>(spans[i].begin());
+      vectors[i].iov_len = spans[i].size();
+    }
+    struct iovec* first = vectors.data();
+    struct iovec* const last = first + batch;
+    while (first != last) {
+      const ssize_t result =
+          pwritev(fd_, first, static_cast<int>(last - first), offset);
+      if (result < 0) {
+        if (errno == EINTR) continue;
+        throw iso9660::Exception("Couldn't write at byte " +
+                                 std::to_string(offset) + ": " +
+                                 std::strerror(errno));
+      }
+      offset += result;
+      // Skip whatever has been written and continue after a short write.
+      auto written = static_cast<std::size_t>(result);
+      while (first != last && written >= first->iov_len) {
+        written -= first->iov_len;
+        ++first;
+      }
+      if (first != last) {
+        first->iov_base =
+            static_cast<iso9660::Byte*>(first->iov_base) + written;
+        first->iov_len -= written;
+      }
+    }
+    spans += batch;
+    count -= batch;
+  }
+}
+
+void iso9660::FileDescriptorDevice::sync(iso9660::Durability durability) {
+  int result = 0;
+  switch (durability) {
+    case iso9660::Durability::NONE:
+      return;
+    case iso9660::Durability::DATA:
+#ifdef __linux__
+      result = fdatasync(fd_);
+      break;
+#endif
+    case iso9660::Durability::FULL:
+      result = fsync(fd_);
+      break;
+  }
+  if (result != 0) {
+    throw iso9660::Exception(std::string("Couldn't sync image: ") +
+                             std::strerror(errno));
+  }
+}
+
+std::uint64_t iso9660::FileDescriptorDevice::capacity() const {
+#ifdef __linux__
+  struct stat status;
+  if (fstat(fd_, &status) == 0 && S_ISBLK(status.st_mode)) return size();
+#endif
+  return iso9660::BlockSink::capacity();
+}
+#else
+iso9660::FileDescriptorDevice::FileDescriptorDevice(int fd) : fd_(fd) {
+  throw iso9660::NotImplementedException(
+      "Positional I/O is not supported on this platform.");
+}
+
+void iso9660::FileDescriptorDevice::read(std::uint64_t offset,
+                                         std::size_t size,
+                                         iso9660::Byte* destination) const {}
+
+std::size_t iso9660::FileDescriptorDevice::transfer(std::uint64_t offset,
+                                                    std::size_t size,
+                                                    int fd) const {
+  return 0;
+}
+
+void iso9660::FileDescriptorDevice::advise(std::uint64_t offset,
+                                           std::size_t size,
+                                           iso9660::Access access) const {}
+
+std::uint64_t iso9660::FileDescriptorDevice::size() const { return 0; }
+
+void iso9660::FileDescriptorDevice::write(std::uint64_t offset,
+                                          const iso9660::Byte* source,
+                                          std::size_t size) {}
+
+void iso9660::FileDescriptorDevice::write_vectored(std::uint64_t offset,
+                                                   const iso9660::Span* spans,
+                                                   std::size_t count) {}
+
+void iso9660::FileDescriptorDevice::sync(iso9660::Durability durability) {}
+
+std::uint64_t iso9660::FileDescriptorDevice::capacity() const {
+  return iso9660::BlockSink::capacity();
+}
+#endif
+
+iso9660::MemoryDevice::MemoryDevice(iso9660::Byte* data, std::size_t size)
+    : data_(data), writable_(data), size_(size) {}
+
+iso9660::MemoryDevice::MemoryDevice(const iso9660::Byte* data,
+                                    std::size_t size)
+    : data_(data), writable_(nullptr), size_(size) {}
+
+void iso9660::MemoryDevice::read(std::uint64_t offset, std::size_t size,
+                                 iso9660::Byte* destination) const {
+  check_range(offset, size, size_);
+  std::memcpy(destination, data_ + offset, size);
+}
+
+iso9660::Span iso9660::MemoryDevice::view(std::uint64_t offset,
+                                          std::size_t size) const {
+  check_range(offset, size, size_);
+  return iso9660::Span(data_ + offset, size);
+}
+
+std::uint64_t iso9660::MemoryDevice::size() const { return size_; }
+
+void iso9660::MemoryDevice::write(std::uint64_t offset,
+                                  const iso9660::Byte* source,
+                                  std::size_t size) {
+  if (writable_ == nullptr) {
+    throw iso9660::Exception("Can't write to a read-only image.");
+  }
+  check_range(offset, size, size_);
+  std::memcpy(writable_ + offset, source, size);
+}
+
+std::uint64_t iso9660::MemoryDevice::capacity() const {
+  return writable_ == nullptr ? 0 : size_;
+}
+
+iso9660::StreamDevice::StreamDevice(std::iostream* stream) : stream_(*stream) {}
+
+void iso9660::StreamDevice::read(std::uint64_t offset, std::size_t size,
+                                 iso9660::Byte* destination) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stream_.clear();
+  stream_.seekg(offset);
+  if (!stream_.read(reinterpret_cast<char*>(destination), size)) {
+    throw iso9660::CorruptFileException("Unexpected end of image at byte " +
+                                        std::to_string(offset) + ".");
+  }
+}
+
+std::uint64_t iso9660::StreamDevice::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stream_.clear();
+  stream_.seekg(0, std::ios::end);
+  return static_cast<std::uint64_t>(stream_.tellg());
+}
+
+void iso9660::StreamDevice::write(std::uint64_t offset,
+                                  const iso9660::Byte* source,
+                                  std::size_t size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stream_.clear();
+  stream_.seekp(offset);
+  if (!stream_.write(reinterpret_cast<const char*>(source), size)) {
+    throw iso9660::Exception("Couldn't write at byte " +
+                             std::to_string(offset) + ".");
+  }
+}
+
+void iso9660::StreamDevice::sync(iso9660::Durability durability) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!stream_.flush()) {
+    throw iso9660::Exception("Couldn't flush image.");
+  }
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "./include/directory-extent.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "./include/buffer.h"
+#include "./include/directory-records.h"
+#include "./include/exception.h"
+#include "./include/layout.h"
+#include "./include/string-view.h"
+
+namespace {
+
+constexpr std::uint64_t NO_POSITION = ~static_cast<std::uint64_t>(0);
+// The directory itself and its parent.
+constexpr std::size_t NUM_SPECIAL_RECORDS = 2;
+
+}  // namespace
+
+iso9660::DirectoryExtent::DirectoryExtent(iso9660::Span extent,
+                                          std::uint64_t position) {
+  iso9660::DirectoryRecords records(extent);
+  for (auto record = records.begin(); record != records.end(); ++record) {
+    const auto span = *record;
+    records_.emplace_back(span.begin(), span.end());
+    positions_.emplace_back(position + record.offset());
+  }
+  if (records_.size() < NUM_SPECIAL_RECORDS) {
+    throw iso9660::CorruptFileException(
+        "Directory at byte " + std::to_string(position) +
+        " does not refer to itself and its parent.");
+  }
+}
+
+/**
+ * Remove the record that has been read from the given position.
+ *
+ * @return Whether the record belongs to this extent.
+ */
+bool iso9660::DirectoryExtent::remove(std::uint64_t position) {
+  auto result = std::find(positions_.begin() + NUM_SPECIAL_RECORDS,
+                          positions_.end(), position);
+  if (result == positions_.end()) return false;
+  const auto index = std::distance(positions_.begin(), result);
+  records_.erase(records_.begin() + index);
+  positions_.erase(result);
+  return true;
+}
+
+void iso9660::DirectoryExtent::insert(std::vector<iso9660::Byte> record) {
+  const auto name = identifier(record);
+  auto result = std::find_if(
+      records_.begin() + NUM_SPECIAL_RECORDS, records_.end(),
+      [&name](const std::vector<iso9660::Byte>& other) {
+        const auto other_name = identifier(other);
+        // Identifiers are ordered by their bytes, e.g. UCS-2 big endian.
+        return std::lexicographical_compare(
+            name.begin(), name.end(), other_name.begin(), other_name.end(),
+            [](char lhs, char rhs) {
+              return static_cast<unsigned char>(lhs) <
+                     static_cast<unsigned char>(rhs);
+            });
+      });
+  const auto index = std::distance(records_.begin(), result);
+  records_.insert(result, std::move(record));
+  positions_.insert(positions_.begin() + index, NO_POSITION);
+}
+
+bool iso9660::DirectoryExtent::contains(iso9660::StringView name) const {
+  return std::any_of(records_.begin() + NUM_SPECIAL_RECORDS, records_.end(),
+                     [&name](const std::vector<iso9660::Byte>& record) {
+                       return identifier(record) == name;
+                     });
+}
+
+std::vector<iso9660::Byte> iso9660::DirectoryExtent::pack(
+    std::size_t min_size) const {
+  std::vector<iso9660::Byte> extent;
+  std::size_t sector_end = 0;
+  for (const auto& record : records_) {
+    if (extent.size() + record.size() > sector_end) {
+      extent.resize(sector_end, 0);
+      sector_end += iso9660::SECTOR_SIZE;
+    }
+    extent.insert(extent.end(), record.begin(), record.end());
+  }
+  extent.resize(std::max(sector_end, min_size), 0);
+  return extent;
+}
+
+iso9660::StringView iso9660::DirectoryExtent::identifier(
+    const std::vector<iso9660::Byte>& record) {
+  namespace layout = iso9660::layout::directory_record;
+  return iso9660::StringView(
+      reinterpret_cast<const char*>(record.data()) + layout::FILE_IDENTIFIER,
+      layout::FileIdentifierLength::read(record.data()));
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "./include/directory-records.h"
+
+#include <string>
+
+#include "./include/buffer.h"
+#include "./include/exception.h"
+#include "./include/layout.h"
+
+iso9660::DirectoryRecords::DirectoryRecords(iso9660::Span extent)
+    : extent_(extent) {}
+
+iso9660::DirectoryRecords::iterator iso9660::DirectoryRecords::begin() const {
+  return iterator(extent_, 0);
+}
+
+iso9660::DirectoryRecords::iterator iso9660::DirectoryRecords::end() const {
+  return iterator(extent_, extent_.size());
+}
+
+iso9660::DirectoryRecords::iterator::iterator(iso9660::Span extent,
+                                              std::size_t offset)
+    : extent_(extent), offset_(offset) {
+  skip_padding();
+}
+
+iso9660::Span iso9660::DirectoryRecords::iterator::operator*() const {
+  return extent_.subspan(offset_, extent_[offset_]);
+}
+
+iso9660::DirectoryRecords::iterator& iso9660::DirectoryRecords::iterator::
+operator++() {
+  offset_ += extent_[offset_];
+  skip_padding();
+  return *this;
+}
+
+bool iso9660::DirectoryRecords::iterator::operator==(
+    const iterator& other) const {
+  return offset_ == other.offset_;
+}
+
+bool iso9660::DirectoryRecords::iterator::operator!=(
+    const iterator& other) const {
+  return offset_ != other.offset_;
+}
+
+std::size_t iso9660::DirectoryRecords::iterator::offset() const {
+  return offset_;
+}
+
+/**
+ * Move to the next record which might be located in the next sector and
+ * make sure that it's not malformed.
+ */
+void iso9660::DirectoryRecords::iterator::skip_padding() {
+  const std::size_t size = extent_.size();
+  while (offset_ < size) {
+    const std::size_t length = extent_[offset_];
+    if (length == 0) {
+      // Skip zero padding at the end of the sector.
+      offset_ = (offset_ + iso9660::SECTOR_SIZE) & -iso9660::SECTOR_SIZE;
+      continue;
+    }
+    namespace layout = iso9660::layout::directory_record;
+    const std::size_t sector_offset = offset_ % iso9660::SECTOR_SIZE;
+    if (length < layout::MIN_SIZE || length > size - offset_ ||
+        sector_offset + length > iso9660::SECTOR_SIZE ||
+        layout::FILE_IDENTIFIER + layout::FileIdentifierLength::read(
+                                      extent_.begin() + offset_) >
+            length) {
+      throw iso9660::CorruptFileException(
+          "Malformed directory record at byte " + std::to_string(offset_) +
+          " of directory extent.");
+    }
+    break;
+  }
+  if (offset_ > size) offset_ = size;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "./include/encoding.h"
+
+#include "./include/buffer.h"
+#include "./include/read.h"
+#include "./include/write.h"
+
+iso9660::encoding::ShortDatetime::type iso9660::encoding::ShortDatetime::read(
+    const iso9660::Byte* first) {
+  return iso9660::read::short_datetime(first, SIZE);
+}
+
+void iso9660::encoding::ShortDatetime::write(iso9660::Byte* const first,
+                                             type value) {
+  iso9660::write::short_datetime(value, first);
+}
+
+iso9660::encoding::LongDatetime::type iso9660::encoding::LongDatetime::read(
+    const iso9660::Byte* first) {
+  return iso9660::read::long_datetime(first, SIZE);
+}
+
+void iso9660::encoding::LongDatetime::write(iso9660::Byte* const first,
+                                            type value) {
+  iso9660::write::long_datetime(value, first);
+}
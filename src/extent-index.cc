@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "./include/extent-index.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "./include/buffer.h"
+#include "./include/file-table.h"
+#include "./include/file.h"
+
+namespace {
+
+/**
+ * An extent covers the extended attribute record and the data of a file.
+ */
+std::uint32_t extent_end(const iso9660::FileTable& files, std::size_t file) {
+  const std::size_t sectors =
+      (files.extended_lengths[file] +
+       iso9660::File::sector_align(files.sizes[file])) /
+      iso9660::SECTOR_SIZE;
+  return static_cast<std::uint32_t>(files.locations[file] + sectors);
+}
+
+}  // namespace
+
+/**
+ * Index every file of the table.
+ */
+void iso9660::ExtentIndex::build(const iso9660::FileTable& files) {
+  extents_.resize(files.size());
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    extents_[i].first = files.locations[i];
+    extents_[i].last = extent_end(files, i);
+    extents_[i].file = static_cast<std::uint32_t>(i);
+  }
+  std::stable_sort(extents_.begin(), extents_.end(),
+                   [](const Extent& lhs, const Extent& rhs) {
+                     return lhs.first < rhs.first;
+                   });
+  update_reach(0);
+}
+
+void iso9660::ExtentIndex::clear() {
+  extents_.clear();
+  reach_.clear();
+}
+
+/**
+ * Number of files that have been indexed.
+ */
+std::size_t iso9660::ExtentIndex::size() const { return extents_.size(); }
+
+/**
+ * The extents that start at the given sector. Files that share their data
+ * share an extent.
+ */
+std::pair<iso9660::ExtentIndex::const_iterator,
+          iso9660::ExtentIndex::const_iterator>
+iso9660::ExtentIndex::at(std::size_t location) const {
+  const Extent wanted = {static_cast<std::uint32_t>(location), 0, 0};
+  return std::equal_range(extents_.begin(), extents_.end(), wanted,
+                          [](const Extent& lhs, const Extent& rhs) {
+                            return lhs.first < rhs.first;
+                          });
+}
+
+/**
+ * Index of every file whose extent overlaps the sectors [first, last) in the
+ * order of their location. Empty files don't occupy any sector.
+ */
+std::vector<std::size_t> iso9660::ExtentIndex::overlapping(
+    std::size_t first, std::size_t last) const {
+  std::vector<std::size_t> files;
+  // Extents before this one end before the first sector.
+  auto begin = std::partition_point(
+      reach_.begin(), reach_.end(),
+      [first](std::uint32_t reach) { return reach <= first; });
+  for (auto extent = extents_.begin() + (begin - reach_.begin());
+       extent != extents_.end() && extent->first < last; ++extent) {
+    if (extent->last > first && extent->first < extent->last) {
+      files.emplace_back(extent->file);
+    }
+  }
+  return files;
+}
+
+/**
+ * The files whose extents start at a sector have been moved to another one in
+ * the table.
+ */
+void iso9660::ExtentIndex::move(const iso9660::FileTable& files,
+                                std::size_t from, std::size_t to) {
+  const auto run = at(from);
+  std::vector<Extent> moved(run.first, run.second);
+  if (moved.empty()) return;
+  std::size_t changed = run.first - extents_.begin();
+  extents_.erase(run.first, run.second);
+  for (auto& extent : moved) {
+    extent.first = static_cast<std::uint32_t>(to);
+    extent.last = extent_end(files, extent.file);
+  }
+  auto position = at(to).second;
+  changed = std::min<std::size_t>(changed, position - extents_.begin());
+  extents_.insert(position, moved.begin(), moved.end());
+  update_reach(changed);
+}
+
+/**
+ * The size of a file has changed in the table. Its extent still starts at the
+ * same sector.
+ */
+void iso9660::ExtentIndex::update(const iso9660::FileTable& files,
+                                  std::size_t file) {
+  const auto run = at(files.locations[file]);
+  for (auto extent = run.first; extent != run.second; ++extent) {
+    if (extent->file != file) continue;
+    const std::size_t changed = extent - extents_.begin();
+    extents_[changed].last = extent_end(files, file);
+    update_reach(changed);
+    return;
+  }
+}
+
+void iso9660::ExtentIndex::update_reach(std::size_t first) {
+  reach_.resize(extents_.size());
+  for (std::size_t i = first; i < extents_.size(); ++i) {
+    reach_[i] = std::max(i == 0 ? 0 : reach_[i - 1], extents_[i].last);
+  }
+}
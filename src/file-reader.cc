@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "./include/file-reader.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "./include/block-device.h"
+#include "./include/buffer.h"
+#include "./include/exception.h"
+#include "./include/file.h"
+
+namespace {
+
+// Large enough to read a configuration file at once.
+constexpr std::size_t MIN_WINDOW = 8 * iso9660::SECTOR_SIZE;
+constexpr std::size_t MAX_WINDOW = 512 * iso9660::SECTOR_SIZE;
+// Larger reads are cheap enough to bypass the window.
+constexpr std::size_t BYPASS_SIZE = 32 * iso9660::SECTOR_SIZE;
+
+}  // namespace
+
+iso9660::FileReader::FileReader(const iso9660::BlockSource* source,
+                                const iso9660::File& file)
+    : source_(source),
+      file_(file),
+      generation_(source->generation()),
+      size_(0),
+      first_(0),
+      next_(0),
+      advised_(0),
+      sequential_(false),
+      window_(MIN_WINDOW),
+      views_(false) {
+  if (file.isdir()) {
+    throw iso9660::NotImplementedException("Can't read a directory.");
+  }
+  locate();
+}
+
+/**
+ * Look up where the extents of the file are.
+ */
+void iso9660::FileReader::locate() {
+  sections_.clear();
+  size_ = 0;
+  for (auto part = file_; part; part = part.next_extent()) {
+    sections_.emplace_back(
+        static_cast<std::uint64_t>(part.location()) * iso9660::SECTOR_SIZE +
+            part.extended_length(),
+        part.size());
+    size_ += part.size();
+  }
+}
+
+/**
+ * Size of the file when it has been read last.
+ */
+std::uint64_t iso9660::FileReader::size() const { return size_; }
+
+std::size_t iso9660::FileReader::window() const { return window_; }
+
+/**
+ * Reads that are at least as large as the window bypass it, as do large reads
+ * from sources without views.
+ */
+std::size_t iso9660::FileReader::read(std::uint64_t offset, std::size_t size,
+                                      iso9660::Byte* destination) {
+  const std::uint64_t generation = source_->generation();
+  if (generation != generation_) {
+    generation_ = generation;
+    filled_ = iso9660::Span();
+    advised_ = 0;
+    locate();
+  }
+  if (offset >= size_) return 0;
+  size =
+      static_cast<std::size_t>(std::min<std::uint64_t>(size, size_ - offset));
+  const bool sequential = offset == next_;
+  if (sequential && !sequential_) {
+    // Whatever follows is likely to be read as well.
+    advise(offset, size_ - offset, iso9660::Access::SEQUENTIAL);
+  } else if (!sequential) {
+    window_ = MIN_WINDOW;
+    advised_ = 0;
+  }
+  sequential_ = sequential;
+  next_ = offset + size;
+  for (std::size_t done = 0; done < size;) {
+    const std::uint64_t position = offset + done;
+    if (position >= first_ && position < first_ + filled_.size()) {
+      const auto count = static_cast<std::size_t>(std::min<std::uint64_t>(
+          size - done, first_ + filled_.size() - position));
+      const auto window = filled_.begin() + (position - first_);
+      std::copy(window, window + count, destination + done);
+      done += count;
+    } else if (size - done >= window_ ||
+               (size - done >= BYPASS_SIZE && !views_)) {
+      read_through(position, size - done, destination + done);
+      done = size;
+      if (sequential_) read_ahead(next_);
+    } else {
+      fill(position);
+    }
+  }
+  return size;
+}
+
+void iso9660::FileReader::fill(std::uint64_t offset) {
+  const auto count = static_cast<std::size_t>(
+      std::min<std::uint64_t>(window_, size_ - offset));
+  // Forget about the window first in case reading it fails.
+  filled_ = iso9660::Span();
+  iso9660::Span view;
+  split(offset, count, [this, count, &view](std::uint64_t position,
+                                            std::size_t size) {
+    // Only a window within a single extent can be viewed.
+    if (size == count) view = source_->view(position, size);
+  });
+  views_ = !view.empty();
+  if (!views_) {
+    if (buffer_.size() < count) buffer_.resize(count);
+    read_through(offset, count, buffer_.data());
+    view = iso9660::Span(buffer_.data(), count);
+  }
+  first_ = offset;
+  filled_ = view;
+  if (sequential_) read_ahead(offset + count);
+}
+
+/**
+ * Grow the window and ask the source to fetch the next one in the background.
+ * The source is only asked again once half of what it has been asked for has
+ * been read.
+ */
+void iso9660::FileReader::read_ahead(std::uint64_t offset) {
+  window_ = std::min(window_ * 2, MAX_WINDOW);
+  const std::uint64_t last = std::min<std::uint64_t>(offset + window_, size_);
+  if (offset + window_ / 2 < advised_ || last <= advised_) return;
+  const std::uint64_t first = std::max(offset, advised_);
+  advise(first, last - first, iso9660::Access::SOON);
+  advised_ = last;
+}
+
+void iso9660::FileReader::read_through(std::uint64_t offset, std::size_t size,
+                                       iso9660::Byte* destination) const {
+  split(offset, size, [this, &destination](std::uint64_t position,
+                                           std::size_t count) {
+    source_->read(position, count, destination);
+    destination += count;
+  });
+}
+
+void iso9660::FileReader::advise(std::uint64_t offset, std::uint64_t size,
+                                 iso9660::Access access) const {
+  split(offset, size, [this, access](std::uint64_t position,
+                                     std::size_t count) {
+    source_->advise(position, count, access);
+  });
+}
+
+/**
+ * Hand the callback the sections of the image that hold the given section of
+ * the file in order.
+ */
+void iso9660::FileReader::split(
+    std::uint64_t offset, std::uint64_t size,
+    const std::function<void(std::uint64_t, std::size_t)>& section) const {
+  for (const auto& extent : sections_) {
+    if (size == 0) break;
+    if (offset >= extent.second) {
+      offset -= extent.second;
+      continue;
+    }
+    const auto count = static_cast<std::size_t>(
+        std::min<std::uint64_t>(size, extent.second - offset));
+    section(extent.first + offset, count);
+    size -= count;
+    offset = 0;
+  }
+}
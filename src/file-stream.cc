@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "./include/file-stream.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <ios>
+#include <istream>
+#include <streambuf>
+
+#include "./include/block-device.h"
+#include "./include/buffer.h"
+
+namespace {
+
+// Large enough to read a configuration file at once.
+constexpr std::size_t BUFFER_SIZE = 32 * iso9660::SECTOR_SIZE;
+
+}  // namespace
+
+iso9660::FileBuffer::FileBuffer(const iso9660::BlockSource* source,
+                                iso9660::BlockSink* sink,
+                                std::uint64_t offset, std::size_t size,
+                                std::size_t capacity)
+    : source_(source),
+      sink_(sink),
+      offset_(offset),
+      size_(size),
+      capacity_(capacity),
+      first_(0),
+      position_(0),
+      buffer_(std::min(BUFFER_SIZE, capacity)) {}
+
+std::size_t iso9660::FileBuffer::size() const {
+  return pbase() != nullptr ? std::max(size_, position()) : size_;
+}
+
+std::size_t iso9660::FileBuffer::capacity() const { return capacity_; }
+
+void iso9660::FileBuffer::truncate(std::size_t size) {
+  flush();
+  size_ = std::min(size_, size);
+}
+
+/**
+ * The get area points straight into the source if it can be viewed.
+ * Otherwise it's read into the buffer.
+ */
+iso9660::FileBuffer::int_type iso9660::FileBuffer::underflow() {
+  flush();
+  if (position_ >= size_) return traits_type::eof();
+  first_ = position_;
+  auto view = source_->view(offset_ + first_, size_ - first_);
+  if (!view.empty()) {
+    // Nothing is ever written through the get area.
+    const auto data = const_cast<char_type*>(
+        reinterpret_cast<const char_type*>(view.begin()));
+    setg(data, data, data + view.size());
+  } else {
+    const std::size_t count = std::min(buffer_.size(), size_ - first_);
+    const auto data = buffer_.data();
+    source_->read(offset_ + first_, count,
+                  reinterpret_cast<iso9660::Byte*>(data));
+    setg(data, data, data + count);
+  }
+  return traits_type::to_int_type(*gptr());
+}
+
+iso9660::FileBuffer::int_type iso9660::FileBuffer::overflow(int_type c) {
+  flush();
+  if (traits_type::eq_int_type(c, traits_type::eof())) {
+    return traits_type::not_eof(c);
+  }
+  if (sink_ == nullptr || position_ >= capacity_) return traits_type::eof();
+  first_ = position_;
+  const auto data = buffer_.data();
+  setp(data, data + std::min(buffer_.size(), capacity_ - first_));
+  *pptr() = traits_type::to_char_type(c);
+  pbump(1);
+  return c;
+}
+
+int iso9660::FileBuffer::sync() {
+  flush();
+  return 0;
+}
+
+/**
+ * Seeking within the get area keeps it. There's only one position for reading
+ * and writing.
+ */
+iso9660::FileBuffer::pos_type iso9660::FileBuffer::seekoff(
+    off_type offset, std::ios_base::seekdir direction,
+    std::ios_base::openmode) {
+  off_type base = 0;
+  if (direction == std::ios_base::cur) {
+    base = static_cast<off_type>(position());
+  } else if (direction == std::ios_base::end) {
+    base = static_cast<off_type>(size());
+  }
+  const off_type target = base + offset;
+  if (target < 0 || target > static_cast<off_type>(capacity_)) {
+    return pos_type(off_type(-1));
+  }
+  const auto position = static_cast<std::size_t>(target);
+  if (eback() != nullptr && position >= first_ &&
+      position <= first_ + static_cast<std::size_t>(egptr() - eback())) {
+    setg(eback(), eback() + (position - first_), egptr());
+    return pos_type(target);
+  }
+  flush();
+  position_ = position;
+  return pos_type(target);
+}
+
+iso9660::FileBuffer::pos_type iso9660::FileBuffer::seekpos(
+    pos_type position, std::ios_base::openmode which) {
+  return seekoff(off_type(position), std::ios_base::beg, which);
+}
+
+std::streamsize iso9660::FileBuffer::showmanyc() {
+  const std::size_t position = this->position();
+  return position < size_ ? static_cast<std::streamsize>(size_ - position)
+                          : -1;
+}
+
+std::streamsize iso9660::FileBuffer::xsgetn(char_type* destination,
+                                            std::streamsize count) {
+  if (static_cast<std::size_t>(count) < buffer_.size()) {
+    return std::streambuf::xsgetn(destination, count);
+  }
+  flush();
+  if (position_ >= size_) return 0;
+  const std::size_t size =
+      std::min(static_cast<std::size_t>(count), size_ - position_);
+  source_->read(offset_ + position_, size,
+                reinterpret_cast<iso9660::Byte*>(destination));
+  position_ += size;
+  return static_cast<std::streamsize>(size);
+}
+
+std::streamsize iso9660::FileBuffer::xsputn(const char_type* source,
+                                            std::streamsize count) {
+  if (static_cast<std::size_t>(count) < buffer_.size()) {
+    return std::streambuf::xsputn(source, count);
+  }
+  flush();
+  if (sink_ == nullptr || position_ >= capacity_) return 0;
+  const std::size_t size =
+      std::min(static_cast<std::size_t>(count), capacity_ - position_);
+  sink_->write(offset_ + position_,
+               reinterpret_cast<const iso9660::Byte*>(source), size);
+  position_ += size;
+  size_ = std::max(size_, position_);
+  return static_cast<std::streamsize>(size);
+}
+
+std::size_t iso9660::FileBuffer::position() const {
+  if (pbase() != nullptr) {
+    return first_ + static_cast<std::size_t>(pptr() - pbase());
+  }
+  if (eback() != nullptr) {
+    return first_ + static_cast<std::size_t>(gptr() - eback());
+  }
+  return position_;
+}
+
+/**
+ * Write whatever is in the put area and drop the get and put area.
+ */
+void iso9660::FileBuffer::flush() {
+  if (pbase() != nullptr) {
+    position_ = position();
+    if (pptr() != pbase()) {
+      sink_->write(offset_ + first_,
+                   reinterpret_cast<const iso9660::Byte*>(pbase()),
+                   static_cast<std::size_t>(pptr() - pbase()));
+    }
+    size_ = std::max(size_, position_);
+    setp(nullptr, nullptr);
+  } else if (eback() != nullptr) {
+    position_ = position();
+    setg(nullptr, nullptr, nullptr);
+  }
+}
+
+iso9660::FileStream::FileStream(const iso9660::BlockSource* source,
+                                iso9660::BlockSink* sink,
+                                std::uint64_t offset, std::size_t size,
+                                std::size_t capacity)
+    : std::iostream(nullptr), buffer_(source, sink, offset, size, capacity) {
+  rdbuf(&buffer_);
+  exceptions(std::ios_base::badbit);
+}
+
+std::size_t iso9660::FileStream::size() const { return buffer_.size(); }
+
+std::size_t iso9660::FileStream::capacity() const {
+  return buffer_.capacity();
+}
+
+void iso9660::FileStream::truncate(std::size_t size) {
+  buffer_.truncate(size);
+}
@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "./include/file-table.h"
+
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "./include/buffer.h"
+#include "./include/exception.h"
+#include "./include/file.h"
+#include "./include/layout.h"
+#include "./include/name-arena.h"
+#include "./include/string-view.h"
+#include "./include/utility.h"
+
+namespace {
+
+template <class T>
+void copy(std::vector<T>* const to, const std::vector<T>& from,
+          std::size_t first, std::size_t last) {
+  to->insert(to->end(), from.begin() + first, from.begin() + last);
+}
+
+}  // namespace
+
+std::size_t iso9660::FileTable::size() const { return locations.size(); }
+
+void iso9660::FileTable::reserve(std::size_t size) {
+  lengths.reserve(size);
+  extended_lengths.reserve(size);
+  locations.reserve(size);
+  sizes.reserve(size);
+  datetimes.reserve(size);
+  flags.reserve(size);
+  file_unit_sizes.reserve(size);
+  interleave_gap_sizes.reserve(size);
+  volume_sequence_numbers.reserve(size);
+  directories.reserve(size);
+  names.reserve(size);
+  positions.reserve(size);
+  primary_positions.reserve(size);
+  primary_names.reserve(size);
+}
+
+/**
+ * Read directory record according to ECMA-119. Note that in ECMA-167
+ * information control block tags are used instead. Joliet names are converted
+ * to UTF-8 right away.
+ *
+ * @return Index of the file.
+ */
+std::size_t iso9660::FileTable::append(iso9660::Span record,
+                                       iso9660::NameArena* const arena,
+                                       std::size_t directory, bool joliet,
+                                       std::uint64_t position) {
+  const auto first = record.begin();
+  namespace layout = iso9660::layout::directory_record;
+  lengths.emplace_back(layout::Length::read(first));
+  // ECMA-119 tells the length in logical blocks.
+  extended_lengths.emplace_back(layout::ExtendedAttributeLength::read(first) *
+                                iso9660::SECTOR_SIZE);
+  locations.emplace_back(layout::Location::read(first));
+  sizes.emplace_back(layout::DataLength::read(first));
+  datetimes.emplace_back(layout::RecordingDatetime::read(first));
+  flags.emplace_back(layout::Flags::read(first));
+  file_unit_sizes.emplace_back(layout::FileUnitSize::read(first));
+  interleave_gap_sizes.emplace_back(layout::InterleaveGapSize::read(first));
+  volume_sequence_numbers.emplace_back(
+      layout::VolumeSequenceNumber::read(first));
+  directories.emplace_back(directory);
+  const auto raw =
+      utility::view(first, layout::FILE_IDENTIFIER,
+                    layout::FileIdentifierLength::read(first));
+  names.emplace_back(joliet ? utility::from_ucs2(raw, arena)
+                            : arena->intern(raw));
+  positions.emplace_back(position);
+  primary_positions.emplace_back(0);
+  primary_names.emplace_back(joliet ? iso9660::StringView() : names.back());
+  // TODO(squimrel): Read rock ridge attributes.
+  return locations.size() - 1;
+}
+
+/**
+ * Append the files [first, last) of another table.
+ */
+void iso9660::FileTable::append(const iso9660::FileTable& other,
+                                std::size_t first, std::size_t last) {
+  copy(&lengths, other.lengths, first, last);
+  copy(&extended_lengths, other.extended_lengths, first, last);
+  copy(&locations, other.locations, first, last);
+  copy(&sizes, other.sizes, first, last);
+  copy(&datetimes, other.datetimes, first, last);
+  copy(&flags, other.flags, first, last);
+  copy(&file_unit_sizes, other.file_unit_sizes, first, last);
+  copy(&interleave_gap_sizes, other.interleave_gap_sizes, first, last);
+  copy(&volume_sequence_numbers, other.volume_sequence_numbers, first, last);
+  copy(&directories, other.directories, first, last);
+  copy(&names, other.names, first, last);
+  copy(&positions, other.positions, first, last);
+  copy(&primary_positions, other.primary_positions, first, last);
+  copy(&primary_names, other.primary_names, first, last);
+}
+
+void iso9660::FileTable::pop_back() {
+  lengths.pop_back();
+  extended_lengths.pop_back();
+  locations.pop_back();
+  sizes.pop_back();
+  datetimes.pop_back();
+  flags.pop_back();
+  file_unit_sizes.pop_back();
+  interleave_gap_sizes.pop_back();
+  volume_sequence_numbers.pop_back();
+  directories.pop_back();
+  names.pop_back();
+  positions.pop_back();
+  primary_positions.pop_back();
+  primary_names.pop_back();
+}
+
+/**
+ * Link the files that have been read from the primary volume descriptor to
+ * the same files of this table. The same file has the same location and size
+ * and is found in the same directory in both volume descriptors; directories
+ * tells which directory of this table each directory of the primary one is.
+ * Files that still can't be told apart, e.g. empty files, are told apart by
+ * their names. Files that can't be told apart at all aren't linked.
+ */
+void iso9660::FileTable::link(const iso9660::FileTable& primary,
+                              const std::vector<std::size_t>& directories) {
+  using Key = std::tuple<std::uint32_t, std::uint32_t, std::size_t>;
+  auto by_key = [](const iso9660::FileTable& table,
+                   const std::vector<Key>& keys) {
+    std::vector<std::size_t> order(table.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&keys](std::size_t lhs, std::size_t rhs) {
+                return keys[lhs] < keys[rhs];
+              });
+    return order;
+  };
+  std::vector<Key> keys(size());
+  for (std::size_t i = 0; i < size(); ++i) {
+    keys[i] = Key(locations[i], sizes[i], this->directories[i]);
+  }
+  std::vector<Key> primary_keys(primary.size());
+  for (std::size_t i = 0; i < primary.size(); ++i) {
+    const std::size_t directory = primary.directories[i];
+    primary_keys[i] =
+        Key(primary.locations[i], primary.sizes[i],
+            directory < directories.size() ? directories[directory]
+                                           : std::size_t(-1));
+  }
+  const auto order = by_key(*this, keys);
+  const auto primary_order = by_key(primary, primary_keys);
+  auto link_file = [this, &primary](std::size_t file, std::size_t record) {
+    primary_positions[file] = primary.positions[record];
+    primary_names[file] = primary.names[record];
+  };
+  // Walk both tables at once, one run of files with the same key at a time.
+  auto file = order.begin();
+  auto record = primary_order.begin();
+  while (file != order.end() && record != primary_order.end()) {
+    const Key key = keys[*file];
+    if (key < primary_keys[*record]) {
+      ++file;
+      continue;
+    }
+    if (primary_keys[*record] < key) {
+      ++record;
+      continue;
+    }
+    auto files_end = file;
+    while (files_end != order.end() && keys[*files_end] == key) ++files_end;
+    auto records_end = record;
+    while (records_end != primary_order.end() &&
+           primary_keys[*records_end] == key) {
+      ++records_end;
+    }
+    if (files_end - file == 1 && records_end - record == 1) {
+      link_file(*file, *record);
+    } else {
+      link_by_name(primary, std::vector<std::size_t>(file, files_end),
+                   std::vector<std::size_t>(record, records_end));
+    }
+    file = files_end;
+    record = records_end;
+  }
+}
+
+/**
+ * Link the files among the given ones whose names only one file of each table
+ * has in common.
+ */
+void iso9660::FileTable::link_by_name(const iso9660::FileTable& primary,
+                                      const std::vector<std::size_t>& files,
+                                      const std::vector<std::size_t>& records) {
+  // The file and the record with each name. The size of the table if more
+  // than one has it and one more than that if none has it.
+  const std::size_t ambiguous = primary.size();
+  std::map<std::string, std::pair<std::size_t, std::size_t>> names;
+  for (const std::size_t file : files) {
+    auto inserted = names.emplace(utility::comparable_name(this->names[file]),
+                                  std::make_pair(file, ambiguous + 1));
+    if (!inserted.second) inserted.first->second.first = size();
+  }
+  for (const std::size_t record : records) {
+    auto name = names.find(utility::comparable_name(primary.names[record]));
+    if (name == names.end()) continue;
+    auto& pair = name->second;
+    pair.second = pair.second == ambiguous + 1 ? record : ambiguous;
+  }
+  for (const auto& name : names) {
+    const auto& pair = name.second;
+    if (pair.first >= size() || pair.second >= ambiguous) continue;
+    primary_positions[pair.first] = primary.positions[pair.second];
+    primary_names[pair.first] = primary.names[pair.second];
+  }
+}
+
+/**
+ * Sum of the sizes of all files.
+ */
+std::uint64_t iso9660::FileTable::total_size() const {
+  return std::accumulate(sizes.begin(), sizes.end(), std::uint64_t(0));
+}
+
+/**
+ * Indices of all files ordered by the location of their data.
+ */
+std::vector<std::size_t> iso9660::FileTable::by_location() const {
+  std::vector<std::size_t> order(size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [this](std::size_t lhs, std::size_t rhs) {
+                     return locations[lhs] < locations[rhs];
+                   });
+  return order;
+}
+
+/**
+ * The size of the data of a directory record without reading the whole
+ * record.
+ */
+std::size_t iso9660::FileTable::data_length(iso9660::Span record) {
+  return iso9660::layout::directory_record::DataLength::read(record.begin());
+}
+
+/**
+ * Make sure that both halves of every both-endian field of a directory record
+ * agree. Disagreement means that the record is corrupt.
+ */
+void iso9660::FileTable::check_both_endian(iso9660::Span record) {
+  namespace layout = iso9660::layout::directory_record;
+  const auto first = record.begin();
+  if (!layout::Location::consistent(first) ||
+      !layout::DataLength::consistent(first) ||
+      !layout::VolumeSequenceNumber::consistent(first)) {
+    throw iso9660::CorruptFileException(
+        "Both-endian fields of a directory record disagree.");
+  }
+}
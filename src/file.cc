@@ -19,54 +19,93 @@
 
 #include "./include/file.h"
 
-#include <algorithm>
-#include <utility>
+#include <cstddef>
+#include <cstdint>
 
+#include "./include/block-device.h"
 #include "./include/buffer.h"
-#include "./include/read.h"
-#include "./include/utility.h"
-
-iso9660::File::File()
-    : length(0),
-      extended_length(0),
-      location(0),
-      size(0),
-      datetime(0),
-      flags(0),
-      file_unit_size(0),
-      interleave_gap_size(0),
-      volume_sequence_number(0) {}
+#include "./include/file-table.h"
+#include "./include/string-view.h"
+#include "./include/write.h"
 
 /**
- * Read directory record according to ECMA-119. Note that in ECMA-167
- * information control block tags are used instead.
+ * A file that does not refer to anything. Evaluates to false.
  */
-iso9660::File::File(iso9660::Buffer::const_iterator first,
-                    iso9660::Buffer::const_iterator last) {
-  constexpr std::size_t SHORT_DATETIME_SIZE = 7;
-  using utility::integer;
-  utility::at(first, last, &length, 0);
-  // + length + (length % 2 == 0 ? 0 : 1);
-  utility::at(first, last, &extended_length, 1);
-  extended_length = std::move(sector_align(extended_length));
-  integer(&location, first + 2, first + 6, 4);
-  integer(&size, first + 10, first + 14, 4);
-  datetime = iso9660::read::short_datetime(first + 18, SHORT_DATETIME_SIZE);
-  utility::at(first, last, &flags, 25);
-  utility::at(first, last, &file_unit_size, 26);
-  utility::at(first, last, &interleave_gap_size, 27);
-  integer(&volume_sequence_number, first + 28, first + 30, 2);
-  std::size_t length = utility::at(first, last, 32);
-  name = utility::substr(first, last, 33, length);
-  // TODO(squimrel): Read rock ridge attributes.
-}
-
-iso9660::File::File(iso9660::Buffer::const_iterator first, std::size_t size) {
-  File(first, first + size);
+iso9660::File::File() : table_(nullptr), index_(0) {}
+
+iso9660::File::File(const iso9660::FileTable* table, std::size_t index)
+    : table_(table), index_(index) {}
+
+std::size_t iso9660::File::length() const { return table_->lengths[index_]; }
+
+std::size_t iso9660::File::extended_length() const {
+  return table_->extended_lengths[index_];
+}
+
+std::size_t iso9660::File::location() const {
+  return table_->locations[index_];
 }
 
+std::size_t iso9660::File::size() const { return table_->sizes[index_]; }
+
+int iso9660::File::datetime() const { return table_->datetimes[index_]; }
+
+int iso9660::File::flags() const { return table_->flags[index_]; }
+
+int iso9660::File::file_unit_size() const {
+  return table_->file_unit_sizes[index_];
+}
+
+int iso9660::File::interleave_gap_size() const {
+  return table_->interleave_gap_sizes[index_];
+}
+
+int iso9660::File::volume_sequence_number() const {
+  return table_->volume_sequence_numbers[index_];
+}
+
+iso9660::StringView iso9660::File::name() const {
+  return table_->names[index_];
+}
+
+/**
+ * Name of the file in the primary volume descriptor. Empty if the file has
+ * been read from a Joliet volume descriptor and hasn't been linked yet.
+ */
+iso9660::StringView iso9660::File::primary_name() const {
+  return table_->primary_names[index_];
+}
+
+/**
+ * Byte offset of the directory record of the file on the image.
+ */
+std::uint64_t iso9660::File::position() const {
+  return table_->positions[index_];
+}
+
+/**
+ * Byte offset of the directory record of the file in the primary volume
+ * descriptor if the file has been read from a Joliet volume descriptor.
+ * Otherwise zero.
+ */
+std::uint64_t iso9660::File::primary_position() const {
+  return table_->primary_positions[index_];
+}
+
+/**
+ * Index of the directory in the path table that contains the file.
+ */
+std::size_t iso9660::File::directory() const {
+  return table_->directories[index_];
+}
+
+/**
+ * Index of the file in the file table.
+ */
+std::size_t iso9660::File::index() const { return index_; }
+
 bool iso9660::File::has(iso9660::File::Flag flag) const {
-  return (flags & static_cast<int>(flag)) != 0;
+  return (flags() & static_cast<int>(flag)) != 0;
 }
 
 /**
@@ -77,10 +116,86 @@ bool iso9660::File::isdir() const {
   return has(iso9660::File::Flag::DIRECTORY);
 }
 
+/**
+ * The data starts at a sector boundary after the extended attribute record so
+ * only the rest of its last sector is free.
+ */
 std::size_t iso9660::File::max_growth() const {
-  return sector_align(size) - size - extended_length;
+  return sector_align(size()) - size();
+}
+
+/**
+ * A file of more than 4 GiB is recorded in several consecutive directory
+ * records, one for each extent. All but the last one are flagged.
+ *
+ * @return The record of the next extent or a file that evaluates to false.
+ */
+iso9660::File iso9660::File::next_extent() const {
+  if (!has(Flag::MULTIPLE_RECORDS) || index_ + 1 >= table_->size() ||
+      table_->directories[index_ + 1] != table_->directories[index_]) {
+    return iso9660::File();
+  }
+  return iso9660::File(table_, index_ + 1);
 }
 
+/**
+ * Write the size to every directory record of the file. The data of the file
+ * is left alone.
+ */
+void iso9660::File::resize(iso9660::BlockSink* const sink,
+                           std::size_t size) const {
+  const std::uint64_t positions[] = {position(), primary_position()};
+  const std::size_t count = positions[1] == 0 ? 1 : 2;
+  iso9660::write::resize_file(sink, positions, positions + count, size);
+}
+
+iso9660::File::operator bool() const { return table_ != nullptr; }
+
 std::size_t iso9660::File::sector_align(std::size_t size) {
   return (size + (iso9660::SECTOR_SIZE - 1)) & -iso9660::SECTOR_SIZE;
 }
+
+iso9660::FileRange::iterator::iterator(const iso9660::FileTable* table,
+                                       std::size_t index)
+    : table_(table), index_(index) {}
+
+iso9660::File iso9660::FileRange::iterator::operator*() const {
+  return iso9660::File(table_, index_);
+}
+
+iso9660::FileRange::iterator& iso9660::FileRange::iterator::operator++() {
+  ++index_;
+  return *this;
+}
+
+bool iso9660::FileRange::iterator::operator==(
+    const iso9660::FileRange::iterator& other) const {
+  return index_ == other.index_;
+}
+
+bool iso9660::FileRange::iterator::operator!=(
+    const iso9660::FileRange::iterator& other) const {
+  return !(*this == other);
+}
+
+iso9660::FileRange::FileRange() : table_(nullptr), first_(0), last_(0) {}
+
+iso9660::FileRange::FileRange(const iso9660::FileTable* table,
+                              std::size_t first, std::size_t last)
+    : table_(table), first_(first), last_(last) {}
+
+iso9660::FileRange::iterator iso9660::FileRange::begin() const {
+  return iterator(table_, first_);
+}
+
+iso9660::FileRange::iterator iso9660::FileRange::end() const {
+  return iterator(table_, last_);
+}
+
+std::size_t iso9660::FileRange::size() const { return last_ - first_; }
+
+bool iso9660::FileRange::empty() const { return first_ == last_; }
+
+iso9660::File iso9660::FileRange::operator[](std::size_t index) const {
+  return iso9660::File(table_, first_ + index);
+}
@@ -19,9 +19,28 @@
 
 #include "./include/image.h"
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <exception>
 #include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 #ifndef NDEBUG
@@ -29,91 +48,312 @@
 #endif
 
 #include "./include/buffer.h"
+#include "./include/directory-extent.h"
+#include "./include/directory-records.h"
 #include "./include/exception.h"
+#include "./include/extent-index.h"
+#include "./include/file-reader.h"
+#include "./include/file-stream.h"
+#include "./include/file-table.h"
 #include "./include/file.h"
+#include "./include/journal.h"
+#include "./include/layout.h"
+#include "./include/name-arena.h"
 #include "./include/path-table.h"
+#include "./include/utility.h"
 #include "./include/volume-descriptor.h"
 #include "./include/write.h"
 
-iso9660::Image::Image(std::fstream* file) : file_(*file) {}
+namespace {
 
-std::vector<iso9660::File> iso9660::Image::read_directory(
-    std::size_t location) {
-  std::size_t position = location * iso9660::SECTOR_SIZE;
-  std::size_t offset = 0;
-  file_.seekg(position);
-  file_.read(reinterpret_cast<char*>(buffer_.data()), iso9660::SECTOR_SIZE);
-  auto record_length = static_cast<std::size_t>(buffer_[offset]);
-  std::vector<iso9660::File> files;
-  while (record_length > 0) {
-    iso9660::File file(buffer_.begin() + offset, buffer_.end());
-    auto result = file_positions_.find(file.location);
-    if (result == file_positions_.end()) {
-      file_positions_.emplace(file.location,
-                              std::vector<std::size_t>({position + offset}));
-    } else {
-      result->second.emplace_back(position + offset);
+// Large copies are done in chunks of this size.
+constexpr std::size_t CHUNK_SIZE = 512 * iso9660::SECTOR_SIZE;
+
+/**
+ * Hand the items [0, count) to the given number of workers, each running on a
+ * thread of its own unless there's only one. The job is told which worker
+ * runs it so that workers can keep state of their own. Once a job throws no
+ * more items are handed out and the first exception is rethrown after all
+ * workers have finished.
+ */
+void run_workers(std::size_t workers, std::size_t count,
+                 const std::function<void(std::size_t, std::size_t)>& job) {
+  std::atomic<std::size_t> next(0);
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto work = [count, &job, &next, &error, &error_mutex](std::size_t worker) {
+    try {
+      for (std::size_t i; (i = next++) < count;) job(worker, i);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!error) error = std::current_exception();
+      // Stop the other workers as soon as possible.
+      next = count;
+    }
+  };
+  if (workers <= 1) {
+    work(0);
+  } else {
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+    try {
+      for (std::size_t i = 0; i < workers; ++i) threads.emplace_back(work, i);
+    } catch (...) {
+      next = count;
+      for (auto& thread : threads) thread.join();
+      throw;
+    }
+    for (auto& thread : threads) thread.join();
+  }
+  if (error) std::rethrow_exception(error);
+}
+
+#ifndef _WIN32
+void write_all(int fd, iso9660::Span data) {
+  auto first = data.begin();
+  std::size_t size = data.size();
+  while (size > 0) {
+    const ssize_t result = ::write(fd, first, size);
+    if (result < 0) {
+      if (errno == EINTR) continue;
+      throw iso9660::Exception(std::string("Couldn't extract file: ") +
+                               std::strerror(errno));
+    }
+    first += result;
+    size -= static_cast<std::size_t>(result);
+  }
+}
+
+void make_directory(const std::string& path) {
+  if (::mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+    throw iso9660::Exception("Couldn't create directory " + path + ": " +
+                             std::strerror(errno));
+  }
+}
+
+/**
+ * Name of a file or directory on disk. The version number of ECMA-119 names
+ * is dropped like the dot of a name without an extension. Names that could
+ * escape the destination are refused.
+ */
+std::string local_name(iso9660::StringView name) {
+  std::string local(name.begin(), std::find(name.begin(), name.end(), ';'));
+  if (local.size() > 1 && local.back() == '.') local.pop_back();
+  if (local.empty() || local == "." || local == ".." ||
+      local.find_first_of(std::string("/\0", 2)) != std::string::npos) {
+    throw iso9660::CorruptFileException("Unsafe file name: " + local);
+  }
+  return local;
+}
+#endif
+
+}  // namespace
+
+iso9660::Image::Image(std::fstream* file)
+    : file_(file),
+      stream_(new iso9660::StreamDevice(file)),
+      source_(stream_.get()),
+      sink_(stream_.get()),
+      journal_(source_, sink_),
+      buffer_(iso9660::SECTOR_SIZE) {}
+
+iso9660::Image::Image(const iso9660::BlockSource* source,
+                      iso9660::BlockSink* sink)
+    : file_(nullptr),
+      source_(source),
+      sink_(sink),
+      journal_(source_, sink_),
+      buffer_(iso9660::SECTOR_SIZE) {}
+
+/**
+ * Provide a view of the given section of the image. If the source keeps the
+ * image in memory this does not copy anything. Otherwise the section is read
+ * into the buffer which means that the view is only valid until the buffer is
+ * used for the next read.
+ */
+iso9660::Span iso9660::Image::read(
+    std::size_t position, std::size_t size,
+    std::vector<iso9660::Byte>* const buffer) const {
+  auto view = journal_.view(position, size);
+  if (!view.empty()) return view;
+  if (size > buffer->size()) {
+    // Don't allocate a huge buffer just because a record is corrupt.
+    const std::uint64_t image_size = journal_.size();
+    if (position > image_size || size > image_size - position) {
+      throw iso9660::CorruptFileException("Unexpected end of image at byte " +
+                                          std::to_string(position) + ".");
+    }
+    buffer->resize(size);
+  }
+  journal_.read(position, size, buffer->data());
+  return iso9660::Span(buffer->data(), size);
+}
+
+iso9660::Span iso9660::Image::read(std::size_t position, std::size_t size) {
+  return read(position, size, &buffer_);
+}
+
+/**
+ * Read all files of a directory and append them to the given table.
+ */
+void iso9660::Image::read_directory(
+    const iso9660::Directory& directory, std::size_t index, bool joliet,
+    std::vector<iso9660::Byte>* const buffer,
+    iso9660::FileTable* const files) const {
+  const std::size_t position = directory.location * iso9660::SECTOR_SIZE;
+  auto extent = read(position, iso9660::SECTOR_SIZE, buffer);
+  /*
+   * The first record describes the directory itself and is the only place
+   * that tells how large the extent is. Read the whole extent at once if it
+   * spans more than one sector.
+   */
+  iso9660::DirectoryRecords records(extent);
+  if (records.begin() == records.end()) return;
+  const std::size_t size = iso9660::FileTable::data_length(*records.begin());
+  if (size > iso9660::SECTOR_SIZE) {
+    extent = read(position, size, buffer);
+    records = iso9660::DirectoryRecords(extent);
+  }
+  for (auto record = records.begin(); record != records.end(); ++record) {
+    if (options_.check_both_endian) {
+      iso9660::FileTable::check_both_endian(*record);
     }
-    offset += file.length;
-    record_length = static_cast<std::size_t>(buffer_[offset]);
+    const std::size_t file = files->append(*record, &names_, index, joliet,
+                                           position + record.offset());
     /*
      * Currently this implementation does not make use of the extra information
      * that is stored in directory record. Extra in the sense that all
      * information this implementation needs to know about directories is
      * already provided by the path table.
      */
-    if (!file.isdir()) {
-      files.emplace_back(std::move(file));
+    if (iso9660::File(files, file).isdir()) files->pop_back();
+  }
+}
+
+/**
+ * Since the path table already tells where each directory is located, all
+ * directories that haven't been read yet can be read independently of each
+ * other.
+ */
+void iso9660::Image::read_directories(iso9660::PathTable* const path_table,
+                                      std::size_t workers) {
+  std::vector<std::size_t> directories;
+  for (std::size_t i = 0; i < path_table->directories.size(); ++i) {
+    if (!path_table->directories[i].loaded) directories.emplace_back(i);
+  }
+  if (directories.empty()) return;
+  workers = std::max<std::size_t>(std::min(workers, directories.size()), 1);
+  /*
+   * Each worker appends to a table of its own. Where the files of a directory
+   * ended up is remembered as the table and the range within it.
+   */
+  struct Slice {
+    std::size_t table;
+    std::size_t first;
+    std::size_t last;
+  };
+  std::vector<iso9660::FileTable> tables(workers);
+  std::vector<std::vector<iso9660::Byte>> buffers(
+      workers, std::vector<iso9660::Byte>(iso9660::SECTOR_SIZE));
+  std::vector<Slice> slices(directories.size());
+  run_workers(workers, directories.size(),
+              [this, path_table, &directories, &tables, &buffers, &slices](
+                  std::size_t worker, std::size_t i) {
+                auto& files = tables[worker];
+                slices[i].table = worker;
+                slices[i].first = files.size();
+                read_directory(path_table->directories[directories[i]],
+                               directories[i], path_table->is_joliet(),
+                               &buffers[worker], &files);
+                slices[i].last = files.size();
+              });
+  if (supplementary_ != nullptr && !path_table->is_joliet()) {
+    // The same files have already been read from the Joliet volume descriptor.
+    iso9660::FileTable primary;
+    for (std::size_t i = 0; i < directories.size(); ++i) {
+      primary.append(tables[slices[i].table], slices[i].first, slices[i].last);
+      path_table->directories[directories[i]].loaded = true;
     }
-    if (offset + record_length >= iso9660::SECTOR_SIZE) {
-      /*
-       * Ignore issue silently. This implementation does not yet allow the sum
-       * of the size of all directory records to be greater than the size of a
-       * sector. Maybe this should throw or at least warn.
-       */
-      break;
+    files_.link(primary,
+                path_table->match(*supplementary_->path_table));
+    return;
+  }
+  // Merge in path table order so that the result never depends on timing.
+  std::size_t total = files_.size();
+  for (const auto& files : tables) total += files.size();
+  files_.reserve(total);
+  for (std::size_t i = 0; i < directories.size(); ++i) {
+    auto& directory = path_table->directories[directories[i]];
+    const std::size_t first = files_.size();
+    files_.append(tables[slices[i].table], slices[i].first, slices[i].last);
+    directory.files = iso9660::FileRange(&files_, first, files_.size());
+    directory.loaded = true;
+  }
+}
+
+/**
+ * The volume descriptor that lookups are done in comes first so that the
+ * files of the other one can be linked to its files.
+ */
+void iso9660::Image::read_all_directories() {
+  for (auto volume : {supplementary_.get(), primary_.get()}) {
+    if (volume != nullptr) {
+      read_directories(volume->path_table.get(), options_.workers);
     }
   }
-  return files;
 }
 
-void iso9660::Image::read_directories(iso9660::PathTable* const path_table) {
-  for (auto& directory : path_table->directories) {
-    directory.files = read_directory(directory.location);
+/**
+ * A file has to be linked to its record in the primary volume descriptor
+ * before it's modified since both records have to be modified. Files that
+ * share their extent with other files and whose names differ too much can't
+ * be linked.
+ */
+void iso9660::Image::check_linked(const iso9660::File& file) {
+  // The record in the primary volume descriptor is linked once it's been read.
+  read_all_directories();
+  if (primary_ != nullptr && supplementary_ != nullptr &&
+      file.primary_position() == 0) {
+    throw iso9660::NotImplementedException(
+        "Can't tell which record of the primary volume descriptor belongs to "
+        "the file since it shares its extent with other files.");
   }
 }
 
+/**
+ * Every file refers to its extent through the index. It's built in bulk as
+ * soon as all directories have been read.
+ */
+const iso9660::ExtentIndex& iso9660::Image::extent_index() {
+  read_all_directories();
+  if (extents_.size() != files_.size()) extents_.build(files_);
+  return extents_;
+}
+
 void iso9660::Image::read_path_table(
     iso9660::VolumeDescriptor* const volume_descriptor) {
   if (volume_descriptor == nullptr) return;
   auto& volume = *volume_descriptor;
-  if (volume.path_table_size > iso9660::SECTOR_SIZE) {
-    throw iso9660::NotImplementedException(
-        "This implementation can't handle path tables that have a size greater "
-        "than the size of one sector.");
-  }
-  std::size_t begin = volume.path_table_location * iso9660::SECTOR_SIZE;
-  std::size_t end = begin + volume.path_table_size;
-  std::size_t maxsize = std::min(iso9660::SECTOR_SIZE, end - begin);
-  file_.seekg(begin);
-  file_.read(reinterpret_cast<char*>(buffer_.data()), maxsize);
+  // The path table is stored contiguously so it's read at once.
+  std::size_t begin = volume.path_table_location() * iso9660::SECTOR_SIZE;
   volume.path_table = std::unique_ptr<iso9660::PathTable>(
-      new iso9660::PathTable(buffer_.begin(), buffer_.begin() + maxsize));
-  read_directories(volume.path_table.get());
+      new iso9660::PathTable(read(begin, volume.path_table_size()), &names_,
+                             volume.joliet_level() > 0));
 }
 
 /**
  * Read any volume descriptor.
  */
-iso9660::SectorType iso9660::Image::read_volume_descriptor() {
-  auto first = buffer_.begin();
-  auto last = buffer_.end();
+iso9660::SectorType iso9660::Image::read_volume_descriptor(
+    iso9660::Span descriptor, std::size_t location) {
+  const auto first = descriptor.begin();
+  namespace layout = iso9660::layout::volume_descriptor_header;
   using iso9660::SectorType;
-  auto type = static_cast<iso9660::SectorType>(utility::at(first, last, 0));
+  auto type = static_cast<iso9660::SectorType>(layout::Type::read(first));
   iso9660::VolumeDescriptorHeader header;
   header.type = type;
-  header.identifier = utility::substr(first, last, 1, 5);
-  utility::at(first, last, &header.version, 6);
+  header.identifier = layout::StandardIdentifier::read(first).str();
+  header.version = layout::Version::read(first);
   auto identifier = identifier_of(header.identifier);
   // Currently only ECMA 119 is understood.
   if (identifier != iso9660::Image::Identifier::ECMA_119) {
@@ -131,8 +371,12 @@ iso9660::SectorType iso9660::Image::read_volume_descriptor() {
     case SectorType::PRIMARY:
     // ECMA 119 - 8.5
     case SectorType::SUPPLEMENTARY: {
+      if (options_.check_both_endian) {
+        iso9660::VolumeDescriptor::check_both_endian(descriptor);
+      }
       std::unique_ptr<iso9660::VolumeDescriptor> tmp(
-          new iso9660::VolumeDescriptor(first, last, std::move(header)));
+          new iso9660::VolumeDescriptor(descriptor, location,
+                                        std::move(header), &names_));
       if (type == SectorType::PRIMARY) {
         primary_ = std::move(tmp);
       } else if (tmp->joliet_level() > 0) {
@@ -156,12 +400,16 @@ iso9660::SectorType iso9660::Image::read_volume_descriptor() {
   return type;
 }
 
-void iso9660::Image::read() {
+void iso9660::Image::read() { read(iso9660::ReadOptions()); }
+
+void iso9660::Image::read(const iso9660::ReadOptions& options) {
+  options_ = options;
   // Skip system area.
-  file_.seekg(iso9660::SYSTEM_AREA_SIZE);
-  for (;;) {
-    file_.read(reinterpret_cast<char*>(buffer_.data()), iso9660::SECTOR_SIZE);
-    if (read_volume_descriptor() == iso9660::SectorType::SET_TERMINATOR) {
+  for (std::size_t position = iso9660::SYSTEM_AREA_SIZE;;
+       position += iso9660::SECTOR_SIZE) {
+    if (read_volume_descriptor(read(position, iso9660::SECTOR_SIZE),
+                               position / iso9660::SECTOR_SIZE) ==
+        iso9660::SectorType::SET_TERMINATOR) {
       break;
     }
   }
@@ -175,45 +423,310 @@ void iso9660::Image::read() {
   }
   read_path_table(primary_.get());
   read_path_table(supplementary_.get());
+  if (!options_.lazy) read_all_directories();
 }
 
 /**
  * After staging modifications one must always write.
  */
-void iso9660::Image::write() {}
+void iso9660::Image::write() { write(iso9660::WriteOptions()); }
 
 /**
- * Find the first file matching by name.
+ * Write all staged modifications at once in the order in which they're located
+ * on the image. If adding or removing files fails, every staged modification
+ * is dropped and the image is read again as it is.
  */
-const iso9660::File* iso9660::Image::find(const std::string& filename) {
-  bool has_supplementary = supplementary_ != nullptr;
-  auto& volume = has_supplementary ? *supplementary_ : *primary_;
-  if (volume.filenames.empty()) {
-    if (has_supplementary) {
-      volume.path_table->joliet();
+void iso9660::Image::write(const iso9660::WriteOptions& options) {
+  const bool edited = !added_.empty() || !removed_.empty();
+  if (edited) {
+    try {
+      edit_directories();
+    } catch (...) {
+      journal_.discard();
+      added_.clear();
+      removed_.clear();
+      reload();
+      throw;
     }
+  }
+  journal_.commit(options.durability);
+  if (edited) reload();
+}
+
+/**
+ * The volume descriptor that lookups are done in. Joliet names are preferred.
+ */
+iso9660::VolumeDescriptor& iso9660::Image::lookup_volume() {
+  if (supplementary_ != nullptr) return *supplementary_;
+  return *primary_;
+}
+
+/**
+ * The files of all directories that have been read so far. A file that is
+ * recorded in both volume descriptors is only listed once.
+ */
+const iso9660::FileTable& iso9660::Image::files() const { return files_; }
+
+/**
+ * Files whose extent overlaps the sectors [first, last) ordered by location,
+ * e.g. to tell what's stored in a section of the image or to check that no
+ * two files overlap.
+ */
+std::vector<iso9660::File> iso9660::Image::overlapping(std::size_t first,
+                                                       std::size_t last) {
+  std::vector<iso9660::File> files;
+  for (const std::size_t file : extent_index().overlapping(first, last)) {
+    files.emplace_back(&files_, file);
+  }
+  return files;
+}
+
+/**
+ * Where the data of a file is located, one section per extent.
+ */
+std::vector<iso9660::Image::Section> iso9660::Image::sections(
+    const iso9660::File& file) const {
+  if (file.isdir()) {
+    throw iso9660::NotImplementedException("Can't read a directory.");
+  }
+  std::vector<Section> sections;
+  for (auto part = file; part; part = part.next_extent()) {
+    sections.emplace_back(
+        static_cast<std::uint64_t>(part.location()) * iso9660::SECTOR_SIZE +
+            part.extended_length(),
+        part.size());
+  }
+  return sections;
+}
+
+/**
+ * Hand a section to the callback in chunks. Chunks are only copied into the
+ * buffer if the source doesn't provide views.
+ */
+void iso9660::Image::read_section(
+    std::uint64_t offset, std::size_t size,
+    std::vector<iso9660::Byte>* const buffer,
+    const std::function<void(iso9660::Span)>& consume) const {
+  while (size > 0) {
+    const std::size_t count = std::min(size, CHUNK_SIZE);
+    auto chunk = journal_.view(offset, count);
+    if (chunk.empty()) {
+      if (buffer->size() < count) buffer->resize(count);
+      journal_.read(offset, count, buffer->data());
+      chunk = iso9660::Span(buffer->data(), count);
+    }
+    consume(chunk);
+    offset += count;
+    size -= count;
+  }
+}
+
+void iso9660::Image::read_file(
+    const iso9660::File& file,
+    const std::function<void(iso9660::Span)>& consume) const {
+  std::vector<iso9660::Byte> buffer;
+  for (const auto& section : sections(file)) {
+    read_section(section.first, section.second, &buffer, consume);
+  }
+}
+
+/**
+ * Whatever the source can't transfer in the kernel is read in large chunks
+ * and written from there.
+ */
+std::uint64_t iso9660::Image::extract(const iso9660::File& file,
+                                      int fd) const {
+#ifndef _WIN32
+  std::uint64_t total = 0;
+  std::vector<iso9660::Byte> buffer;
+  for (const auto& section : sections(file)) {
+    const std::size_t copied =
+        journal_.transfer(section.first, section.second, fd);
+    read_section(section.first + copied, section.second - copied, &buffer,
+                 [fd](iso9660::Span chunk) { write_all(fd, chunk); });
+    total += section.second;
+  }
+  return total;
+#else
+  throw iso9660::NotImplementedException(
+      "Extracting files is not supported on this platform.");
+#endif
+}
+
+iso9660::FileReader iso9660::Image::reader(const iso9660::File& file) const {
+  return iso9660::FileReader(&journal_, file);
+}
+
+iso9660::ExtractStatistics iso9660::Image::extract_all(
+    const std::string& destination) {
+  return extract_all(destination, iso9660::ExtractOptions());
+}
+
+/**
+ * Directories are created up front in path table order which lists parents
+ * before their children. The files are then queued by location so that the
+ * image is read mostly sequentially even though several workers extract files
+ * at once, each through its own file descriptor.
+ */
+iso9660::ExtractStatistics iso9660::Image::extract_all(
+    const std::string& destination, const iso9660::ExtractOptions& options) {
+#ifndef _WIN32
+  const auto start = std::chrono::steady_clock::now();
+  read_all_directories();
+  auto& path_table = *lookup_volume().path_table;
+  const auto& directories = path_table.directories;
+  const std::size_t root = path_table.resolve(options.directory);
+  if (root >= directories.size()) {
+    throw iso9660::Exception("No such directory: " + options.directory);
+  }
+  iso9660::ExtractStatistics statistics;
+  struct Job {
+    iso9660::File file;
+    std::string path;
+  };
+  std::vector<Job> jobs;
+  // Where each directory is extracted to. Empty if it's not extracted.
+  std::vector<std::string> paths(directories.size());
+  make_directory(destination);
+  paths[root] = destination;
+  for (std::size_t i = root; i < directories.size(); ++i) {
+    if (i != root) {
+      const auto parent = static_cast<std::size_t>(directories[i].parent - 1);
+      if (parent >= i || paths[parent].empty()) continue;
+      paths[i] = paths[parent] + '/' + local_name(directories[i].name);
+      make_directory(paths[i]);
+      ++statistics.directories;
+    }
+    // Only the first record of a file that has several is extracted.
+    bool continued = false;
+    for (const auto file : directories[i].files) {
+      if (!file.isdir() && !continued) {
+        jobs.push_back(Job{file, paths[i] + '/' + local_name(file.name())});
+      }
+      continued = file.has(iso9660::File::Flag::MULTIPLE_RECORDS);
+    }
+  }
+  std::stable_sort(jobs.begin(), jobs.end(),
+                   [](const Job& left, const Job& right) {
+                     return left.file.location() < right.file.location();
+                   });
+  std::size_t workers = options.workers;
+  if (workers == 0) workers = std::thread::hardware_concurrency();
+  workers = std::max<std::size_t>(std::min(workers, jobs.size()), 1);
+  // Each worker keeps statistics of its own which are summed up afterwards.
+  std::vector<iso9660::ExtractStatistics> totals(workers);
+  run_workers(workers, jobs.size(), [this, &jobs, &totals](std::size_t worker,
+                                                           std::size_t i) {
+    auto& total = totals[worker];
+    const auto begin = std::chrono::steady_clock::now();
+    const int fd = ::open(jobs[i].path.c_str(),
+                          O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      throw iso9660::Exception("Couldn't create " + jobs[i].path + ": " +
+                               std::strerror(errno));
+    }
+    try {
+      total.bytes += extract(jobs[i].file, fd);
+    } catch (...) {
+      ::close(fd);
+      throw;
+    }
+    if (::close(fd) != 0) {
+      throw iso9660::Exception("Couldn't write " + jobs[i].path + ": " +
+                               std::strerror(errno));
+    }
+    const auto latency = std::chrono::steady_clock::now() - begin;
+    ++total.files;
+    total.total_latency += latency;
+    total.max_latency =
+        std::max<std::chrono::nanoseconds>(total.max_latency, latency);
+  });
+  for (const auto& total : totals) {
+    statistics.files += total.files;
+    statistics.bytes += total.bytes;
+    statistics.total_latency += total.total_latency;
+    statistics.max_latency =
+        std::max(statistics.max_latency, total.max_latency);
+  }
+  statistics.elapsed = std::chrono::steady_clock::now() - start;
+  return statistics;
+#else
+  throw iso9660::NotImplementedException(
+      "Extracting files is not supported on this platform.");
+#endif
+}
+
+/**
+ * Find a file by its path, e.g. "/EFI/BOOT/grub.cfg", or the first file
+ * matching by name if only a name is given.
+ */
+iso9660::File iso9660::Image::find(const std::string& filename) {
+  const std::size_t separator = filename.rfind('/');
+  if (separator != std::string::npos) {
+    const iso9660::StringView path(filename);
+    auto directory = load_directory(path.substr(0, separator));
+    if (directory == nullptr) return iso9660::File();
+    return directory->find(
+        path.substr(separator + 1, path.size() - separator - 1));
+  }
+  auto& volume = lookup_volume();
+  if (volume.filenames.empty()) {
+    // A file can be anywhere so every directory has to be known.
+    read_all_directories();
     volume.build_file_lookup();
   }
   auto result = volume.filenames.find(filename);
   if (result == volume.filenames.end()) {
-    return nullptr;
+    return iso9660::File();
   }
   return result->second;
 }
 
+/**
+ * List the files of a directory given by its path, e.g. "/EFI/BOOT". Only this
+ * directory is read if the image is read lazily.
+ *
+ * @return nullptr if there's no such directory.
+ */
+const iso9660::FileRange* iso9660::Image::list(
+    const std::string& path) {
+  auto directory = load_directory(path);
+  if (directory == nullptr) return nullptr;
+  return &directory->files;
+}
+
+iso9660::Directory* iso9660::Image::load_directory(iso9660::StringView path) {
+  auto& volume = lookup_volume();
+  auto& path_table = *volume.path_table;
+  const std::size_t index = path_table.resolve(path);
+  if (index >= path_table.directories.size()) return nullptr;
+  auto& directory = path_table.directories[index];
+  if (!directory.loaded) {
+    const std::size_t first = files_.size();
+    read_directory(directory, index, path_table.is_joliet(), &buffer_,
+                   &files_);
+    directory.files = iso9660::FileRange(&files_, first, files_.size());
+    directory.loaded = true;
+  }
+  return &directory;
+}
+
 /**
  * An unsafe way to modify a file.
  * Unsafe because the fstream that is exposed to the user has power over the
  * entire ISO 9660 image at the moment even though it should only have power
  * over a tiny file section.
  *
- * TODO: Create an abstraction that provides a specially crafted fstream to the
- * user which can even grow an arbitrary amount.
+ * Prefer the overload that hands a FileStream to the callback. It can't reach
+ * beyond the file and tells the new size by itself.
+ *
+ * A file that grows a lot can be replaced with remove_file and add_file
+ * instead. The new content is then streamed into the image when it's written.
  *
- * An easier solution would be to have a remove_file and add_file function.
- * Where the add_file function will be given an ifstream that will have to live
- * until write. Especially if the modified file will exceed the maximum allowed
- * growth such an solution would most likely be preferable.
+ * Whatever is written to the fstream reaches the image right away. Only the new
+ * size of the file is staged until the image is written. Staged modifications
+ * of the file's extent are written first so that they can't overwrite what's
+ * written to the fstream later on.
  *
  * Note: Maybe a template should be used instead of std::function.
  */
@@ -221,24 +734,560 @@ bool iso9660::Image::modify_file(
     const iso9660::File& file,
     std::function<std::streamsize(std::fstream*, const iso9660::File&)>
         modify) {
-  file_.seekg(file.location * iso9660::SECTOR_SIZE + file.extended_length);
-  std::streamsize growth = modify(&file_, file);
+  if (file_ == nullptr) {
+    throw iso9660::NotImplementedException(
+        "Only images that have been opened as an fstream can be modified "
+        "through an fstream.");
+  }
+  check_linked(file);
+  const std::uint64_t offset =
+      static_cast<std::uint64_t>(file.location()) * iso9660::SECTOR_SIZE;
+  journal_.commit(offset, extent_capacity(file), iso9660::Durability::NONE);
+  file_->clear();
+  file_->seekg(offset + file.extended_length());
+  return resize_file(file, modify(file_, file));
+}
+
+/**
+ * The callback is expected to write the new content of the file to the sink at
+ * file.location() * SECTOR_SIZE + file.extended_length(). Nothing reaches the
+ * image before it's written.
+ */
+bool iso9660::Image::modify_file(
+    const iso9660::File& file,
+    std::function<std::streamsize(iso9660::BlockSink*, const iso9660::File&)>
+        modify) {
+  if (sink_ == nullptr) {
+    throw iso9660::NotImplementedException(
+        "Can't modify an image that has been opened without a sink.");
+  }
+  check_linked(file);
+  return resize_file(file, modify(&journal_, file));
+}
+
+bool iso9660::Image::modify_file(
+    const iso9660::File& file,
+    std::function<void(iso9660::FileStream*, const iso9660::File&)> modify) {
+  if (sink_ == nullptr) {
+    throw iso9660::NotImplementedException(
+        "Can't modify an image that has been opened without a sink.");
+  }
+  check_linked(file);
+  iso9660::FileStream stream(
+      &journal_, &journal_,
+      static_cast<std::uint64_t>(file.location()) * iso9660::SECTOR_SIZE +
+          file.extended_length(),
+      file.size(), extent_capacity(file) - file.extended_length());
+  modify(&stream, file);
+  stream.flush();
+  return resize_file(file, static_cast<std::streamsize>(stream.size()) -
+                               static_cast<std::streamsize>(file.size()));
+}
+
+bool iso9660::Image::resize_file(const iso9660::File& file,
+                                 std::streamsize growth) {
   if (growth == 0) return false;
-  auto result = file_positions_.find(file.location);
-  if (result == file_positions_.end()) {
-    throw iso9660::CorruptFileException("Could not find file location.");
+  const std::size_t size = file.size() + growth;
+  file.resize(&journal_, size);
+  files_.sizes[file.index()] = static_cast<std::uint32_t>(size);
+  // The index is only kept up to date once it's been built.
+  if (extents_.size() == files_.size()) extents_.update(files_, file.index());
+  return true;
+}
+
+/**
+ * Relocation is necessary if a file grows by more than File::max_growth().
+ *
+ * The extent is appended after whatever is last on the image, i.e. the volume
+ * space or the end of the source if it's larger. Sectors beyond the volume
+ * space aren't necessarily free since hybrid images append partitions there.
+ * For the same reason sectors that no directory refers to aren't reused.
+ *
+ * The content is copied to the new extent right away since nothing refers to
+ * it yet. The new location of the files and the new size of the volume space
+ * are staged until the image is written. Until then the copy is just unused
+ * space.
+ */
+bool iso9660::Image::relocate_file(const iso9660::File& file,
+                                   std::size_t size) {
+  if (sink_ == nullptr) {
+    throw iso9660::NotImplementedException(
+        "Can't modify an image that has been opened without a sink.");
   }
+  if (file.isdir()) {
+    throw iso9660::NotImplementedException("Can't relocate a directory.");
+  }
+  const std::size_t from = file.location();
+  if (file.extended_length() + size <= extent_capacity(file)) return false;
   /*
-   * FIXME: This is messy. In the future the supplementary and primary files
-   * should be summarized in a single File instance so that a lookup like this
-   * does not need to be done.
-   * When that has been done resize should be a member function of File.
+   * Every file that refers to the extent is moved along with it, so the
+   * content of the largest one is copied.
    */
-  iso9660::write::resize_file(&file_, result->second.begin(),
-                              result->second.end(), file.size + growth);
+  const auto extents = extent_index().at(from);
+  std::size_t content = 0;
+  for (auto extent = extents.first; extent != extents.second; ++extent) {
+    const iso9660::File shared(&files_, extent->file);
+    check_linked(shared);
+    content = std::max(content, shared.extended_length() + shared.size());
+  }
+  const std::size_t to = volume_end();
+  const std::size_t extent_size = iso9660::File::sector_align(
+      std::max(content, file.extended_length() + size));
+  check_room(to + extent_size / iso9660::SECTOR_SIZE);
+  copy_sectors(journal_,
+               static_cast<std::uint64_t>(from) * iso9660::SECTOR_SIZE,
+               sink_, to, content, extent_size);
+
+  namespace layout = iso9660::layout::directory_record;
+  std::array<iso9660::Byte, layout::Location::SIZE> encoded;
+  layout::Location::encoding_type::write(
+      encoded.data(), static_cast<layout::Location::type>(to));
+  for (auto extent = extents.first; extent != extents.second; ++extent) {
+    const std::size_t i = extent->file;
+    for (const auto position :
+         {files_.positions[i], files_.primary_positions[i]}) {
+      if (position == 0) continue;
+      journal_.write(position + layout::Location::OFFSET, encoded.data(),
+                     encoded.size());
+    }
+    files_.locations[i] = static_cast<std::uint32_t>(to);
+  }
+  extents_.move(files_, from, to);
+  reserved_.erase(from);
+  reserved_[to] = extent_size;
+
+  const std::size_t end = to + extent_size / iso9660::SECTOR_SIZE;
+  for (auto volume : {primary_.get(), supplementary_.get()}) {
+    if (volume == nullptr) continue;
+    volume->set_volume_space_size(end);
+    const auto sector = volume->sector();
+    journal_.write(volume->location * iso9660::SECTOR_SIZE, sector.begin(),
+                   sector.size());
+  }
   return true;
 }
 
+/**
+ * The first sector after the volume space and everything that follows it.
+ */
+std::size_t iso9660::Image::volume_end() const {
+  std::size_t end =
+      (journal_.size() + iso9660::SECTOR_SIZE - 1) / iso9660::SECTOR_SIZE;
+  for (auto volume : {primary_.get(), supplementary_.get()}) {
+    if (volume != nullptr) end = std::max(end, volume->volume_space_size());
+  }
+  return end;
+}
+
+/**
+ * Make sure that the image can grow up to the given sector.
+ */
+void iso9660::Image::check_room(std::size_t end) const {
+  const std::uint64_t capacity = journal_.capacity();
+  if (static_cast<std::uint64_t>(end) * iso9660::SECTOR_SIZE > capacity) {
+    throw iso9660::NotImplementedException(
+        "The image would have to grow to " +
+        std::to_string(static_cast<std::uint64_t>(end) *
+                       iso9660::SECTOR_SIZE) +
+        " bytes but its sink can only hold " + std::to_string(capacity) +
+        " bytes.");
+  }
+}
+
+/**
+ * Bytes of the extent of a file including its extended attribute record. A
+ * file that has been relocated may have more room than it needs yet.
+ */
+std::size_t iso9660::Image::extent_capacity(
+    const iso9660::File& file) const {
+  auto reserved = reserved_.find(file.location());
+  if (reserved != reserved_.end()) return reserved->second;
+  return iso9660::File::sector_align(file.extended_length() + file.size());
+}
+
+/**
+ * Copy size bytes from the given offset of a source to an extent in large
+ * chunks that are a multiple of the sector size. The rest of the extent of
+ * extent_size bytes is zeroed. Writing straight to the sink of the image is
+ * only safe if nothing refers to the extent yet.
+ */
+void iso9660::Image::copy_sectors(const iso9660::BlockSource& source,
+                                  std::uint64_t offset,
+                                  iso9660::BlockSink* const sink,
+                                  std::size_t to, std::size_t size,
+                                  std::size_t extent_size) {
+  std::vector<iso9660::Byte> chunk(std::min(CHUNK_SIZE, extent_size));
+  std::uint64_t destination =
+      static_cast<std::uint64_t>(to) * iso9660::SECTOR_SIZE;
+  for (std::size_t done = 0; done < extent_size;) {
+    const std::size_t count = std::min(extent_size - done, chunk.size());
+    const std::size_t copied = done < size ? std::min(size - done, count) : 0;
+    source.read(offset, copied, chunk.data());
+    std::fill(chunk.begin() + copied, chunk.begin() + count, 0);
+    sink->write(destination, chunk.data(), count);
+    offset += copied;
+    destination += count;
+    done += count;
+  }
+}
+
+/**
+ * Add a file to an existing directory when the image is written. Everything
+ * that could make writing the image fail is checked right away.
+ */
+void iso9660::Image::add_file(const std::string& path,
+                              const iso9660::BlockSource* content) {
+  if (sink_ == nullptr) {
+    throw iso9660::NotImplementedException(
+        "Can't modify an image that has been opened without a sink.");
+  }
+  const std::size_t separator = path.rfind('/');
+  const std::string directory =
+      separator == std::string::npos ? "" : path.substr(0, separator);
+  const std::string name =
+      separator == std::string::npos ? path : path.substr(separator + 1);
+  if (name.empty()) {
+    throw iso9660::Exception("Can't add a file without a name: " + path);
+  }
+  const std::uint64_t size = content->size();
+  if (size > std::numeric_limits<std::uint32_t>::max()) {
+    throw iso9660::NotImplementedException(
+        "Can't add a file of 4 GiB or more: " + path);
+  }
+  auto existing = load_directory(directory);
+  if (existing == nullptr) {
+    throw iso9660::NotImplementedException(
+        "Can't create directories. No such directory: " + directory);
+  }
+  if (existing->find(name)) {
+    throw iso9660::Exception("File already exists: " + path);
+  }
+  AddedFile added{directory, name, content, static_cast<std::size_t>(size),
+                  0, 0};
+  /*
+   * The directory is looked up by its path in one volume descriptor and
+   * matched to the same directory of the other one since names may have been
+   * shortened in the primary volume descriptor.
+   */
+  const std::size_t index = lookup_volume().path_table->resolve(directory);
+  if (supplementary_ != nullptr) {
+    added.supplementary_directory = index;
+    if (primary_ != nullptr) {
+      const auto& primary = *primary_->path_table;
+      const auto matches = primary.match(*supplementary_->path_table);
+      const auto match = std::find(matches.begin(), matches.end(), index);
+      if (match == matches.end()) {
+        throw iso9660::NotImplementedException(
+            "Can't find " + directory + " in the primary volume descriptor.");
+      }
+      added.primary_directory = match - matches.begin();
+    }
+  } else {
+    added.primary_directory = index;
+  }
+  for (auto volume : {primary_.get(), supplementary_.get()}) {
+    if (volume == nullptr) continue;
+    const std::size_t directory_index = added.directory_in(*volume);
+    const bool joliet = volume->path_table->is_joliet();
+    const std::string identifier = record_identifier(name, joliet);
+    const std::size_t location =
+        volume->path_table->directories[directory_index].location;
+    const std::uint64_t position =
+        static_cast<std::uint64_t>(location) * iso9660::SECTOR_SIZE;
+    const iso9660::DirectoryExtent extent(
+        read(position, directory_size(location)), position);
+    bool exists = extent.contains(identifier);
+    for (const auto& other : added_) {
+      exists |= other.directory_in(*volume) == directory_index &&
+                record_identifier(other.name, joliet) == identifier;
+    }
+    if (exists) {
+      throw iso9660::Exception(
+          std::string(joliet ? "File already exists: "
+                             : "File already exists in the primary volume "
+                               "descriptor: ") +
+          path);
+    }
+  }
+  added_.push_back(std::move(added));
+}
+
+void iso9660::Image::remove_file(const iso9660::File& file) {
+  if (sink_ == nullptr) {
+    throw iso9660::NotImplementedException(
+        "Can't modify an image that has been opened without a sink.");
+  }
+  if (file.isdir()) {
+    throw iso9660::NotImplementedException("Can't remove a directory.");
+  }
+  check_linked(file);
+  removed_.push_back(file.position());
+  if (file.primary_position() != 0) {
+    removed_.push_back(file.primary_position());
+  }
+}
+
+/**
+ * Index of the directory the file is added to in the path table of the given
+ * volume descriptor.
+ */
+std::size_t iso9660::Image::AddedFile::directory_in(
+    const iso9660::VolumeDescriptor& volume) const {
+  return volume.path_table->is_joliet() ? supplementary_directory
+                                        : primary_directory;
+}
+
+/**
+ * Identifier of a file in the directory records of a volume descriptor.
+ */
+std::string iso9660::Image::record_identifier(const std::string& name,
+                                              bool joliet) {
+  return joliet ? utility::to_ucs2(name)
+                : utility::to_d_characters(name, false);
+}
+
+/**
+ * Add and remove files. Every change is planned before anything is written so
+ * that nothing reaches the image if the edit fails. The content of added files
+ * is then written to the end of the image in one pass. Afterwards every
+ * directory that has changed is written once in both volume descriptors.
+ */
+void iso9660::Image::edit_directories() {
+  read_all_directories();
+  std::size_t end = volume_end();
+  std::vector<std::size_t> locations;
+  for (const auto& added : added_) {
+    locations.emplace_back(end);
+    end += iso9660::File::sector_align(added.size) / iso9660::SECTOR_SIZE;
+  }
+  std::vector<DirectoryEdit> edits;
+  for (auto volume : {primary_.get(), supplementary_.get()}) {
+    if (volume != nullptr) {
+      edits.push_back(plan_directories(volume, locations, &end));
+    }
+  }
+  check_room(end);
+  // Nothing refers to the content yet so it doesn't have to be staged.
+  for (std::size_t i = 0; i < added_.size(); ++i) {
+    copy_sectors(*added_[i].content, 0, sink_, locations[i], added_[i].size,
+                 iso9660::File::sector_align(added_[i].size));
+  }
+  for (const auto& edit : edits) {
+    for (const auto& extent : edit.extents) {
+      journal_.write(
+          static_cast<std::uint64_t>(extent.first) * iso9660::SECTOR_SIZE,
+          extent.second.data(), extent.second.size());
+    }
+    for (const auto& table : edit.path_tables) {
+      journal_.write(table.first, table.second.data(), table.second.size());
+    }
+    auto& volume = *edit.volume;
+    if (edit.root_moved) {
+      volume.set_root_directory(edit.root_location, edit.root_size);
+    }
+    volume.set_volume_space_size(std::max(end, volume.volume_space_size()));
+    const auto sector = volume.sector();
+    journal_.write(volume.location * iso9660::SECTOR_SIZE, sector.begin(),
+                   sector.size());
+  }
+  added_.clear();
+  removed_.clear();
+}
+
+/**
+ * Work out how every directory of a volume descriptor that has changed is
+ * rewritten. A directory that doesn't fit into its extent anymore is moved to
+ * the end of the image. Nothing is written.
+ */
+iso9660::Image::DirectoryEdit iso9660::Image::plan_directories(
+    iso9660::VolumeDescriptor* const volume,
+    const std::vector<std::size_t>& locations, std::size_t* const end) {
+  DirectoryEdit edit;
+  edit.volume = volume;
+  edit.root_moved = false;
+  auto& path_table = *volume->path_table;
+  const bool joliet = path_table.is_joliet();
+  const std::size_t count = path_table.directories.size();
+  std::vector<std::size_t> extent_locations(count);
+  std::vector<std::size_t> extent_sizes(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    extent_locations[i] = path_table.directories[i].location;
+    extent_sizes[i] = directory_size(extent_locations[i]);
+  }
+  // Index of the directory of each added and removed file.
+  std::vector<std::size_t> added(added_.size());
+  for (std::size_t i = 0; i < added_.size(); ++i) {
+    added[i] = added_[i].directory_in(*volume);
+  }
+  std::vector<std::size_t> removed(removed_.size(), count);
+  for (std::size_t i = 0; i < removed_.size(); ++i) {
+    for (std::size_t j = 0; j < count; ++j) {
+      const std::uint64_t first =
+          static_cast<std::uint64_t>(extent_locations[j]) *
+          iso9660::SECTOR_SIZE;
+      if (removed_[i] >= first && removed_[i] < first + extent_sizes[j]) {
+        removed[i] = j;
+        break;
+      }
+    }
+  }
+  const auto now = static_cast<int>(std::time(nullptr));
+  // Directories that are written by their index in the path table.
+  std::map<std::size_t, std::vector<iso9660::Byte>> extents;
+  std::vector<bool> moving(count, false);
+  for (std::size_t index = 0; index < count; ++index) {
+    if (std::find(added.begin(), added.end(), index) == added.end() &&
+        std::find(removed.begin(), removed.end(), index) == removed.end()) {
+      continue;
+    }
+    const std::uint64_t position =
+        static_cast<std::uint64_t>(extent_locations[index]) *
+        iso9660::SECTOR_SIZE;
+    iso9660::DirectoryExtent extent(read(position, extent_sizes[index]),
+                                    position);
+    for (std::size_t i = 0; i < removed_.size(); ++i) {
+      if (removed[i] == index) extent.remove(removed_[i]);
+    }
+    for (std::size_t i = 0; i < added_.size(); ++i) {
+      if (added[i] != index) continue;
+      const std::string identifier = record_identifier(added_[i].name, joliet);
+      if (extent.contains(identifier)) {
+        throw iso9660::Exception("File already exists: " + added_[i].name);
+      }
+      extent.insert(iso9660::write::directory_record(
+          locations[i], added_[i].size, now, 0, identifier));
+    }
+    auto records = extent.pack(extent_sizes[index]);
+    if (records.size() != extent_sizes[index]) {
+      moving[index] = true;
+      extent_sizes[index] = records.size();
+    }
+    extents[index] = std::move(records);
+  }
+  /*
+   * A directory that doesn't fit into its extent anymore is moved to the end
+   * of the image. Readers that read an image front to back expect a directory
+   * to come after its parent, so all subdirectories are moved as well. The
+   * parent of a directory always comes first in the path table.
+   */
+  auto& directories = path_table.directories;
+  const auto previous_locations = extent_locations;
+  for (std::size_t index = 1; index < count; ++index) {
+    if (moving[directories[index].parent - 1]) moving[index] = true;
+  }
+  std::unordered_map<std::size_t, std::pair<std::size_t, std::size_t>> moved;
+  for (std::size_t index = 0; index < count; ++index) {
+    if (!moving[index]) continue;
+    moved[extent_locations[index]] =
+        std::make_pair(*end, extent_sizes[index]);
+    extent_locations[index] = *end;
+    *end += extent_sizes[index] / iso9660::SECTOR_SIZE;
+    // The parent refers to the new extent.
+    // The root directory is its own parent whatever its record tells.
+    const std::size_t parent =
+        index == 0 ? 0
+                   : static_cast<std::size_t>(directories[index].parent - 1);
+    for (const std::size_t touched : {index, parent}) {
+      if (extents.find(touched) != extents.end()) continue;
+      auto extent = read(previous_locations[touched] * iso9660::SECTOR_SIZE,
+                         extent_sizes[touched]);
+      extents[touched].assign(extent.begin(), extent.end());
+    }
+  }
+  for (auto& extent : extents) {
+    refer_to_moved(&extent.second, moved);
+    edit.extents[extent_locations[extent.first]] = std::move(extent.second);
+  }
+  if (moved.empty()) return edit;
+  if (moving[0]) {
+    edit.root_moved = true;
+    edit.root_location = extent_locations[0];
+    edit.root_size = extent_sizes[0];
+  }
+  // Path table records are numbered like the directories.
+  const std::size_t tables[] = {volume->type_l_path_table_location(),
+                                volume->optional_type_l_path_table_location(),
+                                volume->path_table_location(),
+                                volume->optional_path_table_location()};
+  for (std::size_t t = 0; t < 4; ++t) {
+    if (tables[t] == 0) continue;
+    const std::uint64_t position =
+        static_cast<std::uint64_t>(tables[t]) * iso9660::SECTOR_SIZE;
+    auto span = read(position, volume->path_table_size());
+    std::vector<iso9660::Byte> table(span.begin(), span.end());
+    namespace layout = iso9660::layout::path_table_record;
+    std::size_t offset = 0;
+    for (std::size_t index = 0;
+         index < count && offset + layout::MIN_SIZE <= table.size();
+         ++index) {
+      const auto record = table.data() + offset;
+      if (moving[index]) {
+        const auto location = static_cast<std::uint32_t>(
+            extent_locations[index]);
+        if (t < 2) {
+          iso9660::encoding::Uint32LE::write(
+              record + layout::Location::OFFSET, location);
+        } else {
+          layout::Location::write(record, location);
+        }
+      }
+      const std::size_t length =
+          layout::DirectoryIdentifierLength::read(record);
+      offset += layout::DIRECTORY_IDENTIFIER + length + length % 2;
+    }
+    edit.path_tables[position] = std::move(table);
+  }
+  return edit;
+}
+
+/**
+ * Size of a directory extent as told by the record of the directory itself.
+ */
+std::size_t iso9660::Image::directory_size(std::size_t location) {
+  auto extent = read(location * iso9660::SECTOR_SIZE, iso9660::SECTOR_SIZE);
+  iso9660::DirectoryRecords records(extent);
+  if (records.begin() == records.end()) {
+    throw iso9660::CorruptFileException(
+        "Directory at sector " + std::to_string(location) + " is empty.");
+  }
+  return iso9660::FileTable::data_length(*records.begin());
+}
+
+/**
+ * Make the directory records of an extent that refer to a directory that has
+ * been moved refer to its new extent. Moved directories are given by their
+ * previous location.
+ */
+void iso9660::Image::refer_to_moved(
+    std::vector<iso9660::Byte>* const extent,
+    const std::unordered_map<std::size_t, std::pair<std::size_t, std::size_t>>&
+        moved) {
+  namespace layout = iso9660::layout::directory_record;
+  iso9660::DirectoryRecords records(
+      iso9660::Span(extent->data(), extent->size()));
+  for (auto record = records.begin(); record != records.end(); ++record) {
+    const auto first = extent->data() + record.offset();
+    if (!(layout::Flags::read(first) & 2)) continue;
+    auto result = moved.find(layout::Location::read(first));
+    if (result == moved.end()) continue;
+    layout::Location::write(
+        first, static_cast<layout::Location::type>(result->second.first));
+    layout::DataLength::write(
+        first, static_cast<layout::DataLength::type>(result->second.second));
+  }
+}
+
+/**
+ * Forget everything that has been read and read the image again.
+ */
+void iso9660::Image::reload() {
+  primary_.reset();
+  supplementary_.reset();
+  files_ = iso9660::FileTable();
+  extents_.clear();
+  read(options_);
+}
+
 iso9660::Image::Identifier iso9660::Image::identifier_of(
     const std::string& identifier) {
   static const std::unordered_map<std::string, iso9660::Image::Identifier>
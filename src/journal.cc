@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "./include/journal.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include "./include/block-device.h"
+#include "./include/buffer.h"
+#include "./include/exception.h"
+
+namespace {
+
+constexpr std::uint64_t ALL = ~static_cast<std::uint64_t>(0);
+constexpr std::size_t WORD = 64;
+// Upper bound of what is read at once when dirty sectors are completed.
+constexpr std::size_t MAX_READ_SECTORS = 512;
+
+}  // namespace
+
+iso9660::Journal::Journal(const iso9660::BlockSource* source,
+                          iso9660::BlockSink* sink)
+    : source_(source), sink_(sink), generation_(0) {}
+
+/**
+ * Read from the image and replace whatever is staged on the way.
+ */
+void iso9660::Journal::read(std::uint64_t offset, std::size_t size,
+                            iso9660::Byte* destination) const {
+  const std::uint64_t last = offset + size;
+  auto first = sectors_.lower_bound(offset / iso9660::SECTOR_SIZE);
+  if (first == sectors_.end() ||
+      static_cast<std::uint64_t>(first->first) * iso9660::SECTOR_SIZE >=
+          last) {
+    source_->read(offset, size, destination);
+    return;
+  }
+  // Sectors that have been written past the end of the image can't be read.
+  const std::uint64_t end = std::min(last, source_->size());
+  std::memset(destination, 0, size);
+  if (offset < end) {
+    source_->read(offset, static_cast<std::size_t>(end - offset), destination);
+  }
+  for (; first != sectors_.end(); ++first) {
+    const std::uint64_t begin =
+        static_cast<std::uint64_t>(first->first) * iso9660::SECTOR_SIZE;
+    if (begin >= last) break;
+    const std::uint64_t from = std::max(begin, offset);
+    const std::uint64_t to = std::min(begin + iso9660::SECTOR_SIZE, last);
+    first->second.overlay(static_cast<std::size_t>(from - begin),
+                          static_cast<std::size_t>(to - from),
+                          destination + (from - offset));
+  }
+}
+
+/**
+ * Only sections without staged writes can be viewed.
+ */
+iso9660::Span iso9660::Journal::view(std::uint64_t offset,
+                                     std::size_t size) const {
+  if (staged(offset, size)) return iso9660::Span();
+  return source_->view(offset, size);
+}
+
+/**
+ * Like views, only sections without staged writes can be transferred.
+ */
+std::size_t iso9660::Journal::transfer(std::uint64_t offset, std::size_t size,
+                                       int fd) const {
+  if (staged(offset, size)) return 0;
+  return source_->transfer(offset, size, fd);
+}
+
+void iso9660::Journal::advise(std::uint64_t offset, std::size_t size,
+                              iso9660::Access access) const {
+  source_->advise(offset, size, access);
+}
+
+/**
+ * Whether a write to a section of the image has been staged.
+ */
+bool iso9660::Journal::staged(std::uint64_t offset, std::size_t size) const {
+  auto dirty = sectors_.lower_bound(offset / iso9660::SECTOR_SIZE);
+  return dirty != sectors_.end() &&
+         static_cast<std::uint64_t>(dirty->first) * iso9660::SECTOR_SIZE <
+             offset + size;
+}
+
+/**
+ * Sectors that are written past the end of the image grow it.
+ */
+std::uint64_t iso9660::Journal::size() const {
+  const std::uint64_t size = source_->size();
+  if (sectors_.empty()) return size;
+  return std::max<std::uint64_t>(
+      size, static_cast<std::uint64_t>(sectors_.rbegin()->first + 1) *
+                iso9660::SECTOR_SIZE);
+}
+
+std::uint64_t iso9660::Journal::generation() const { return generation_; }
+
+void iso9660::Journal::write(std::uint64_t offset,
+                             const iso9660::Byte* source, std::size_t size) {
+  if (sink_ == nullptr) {
+    throw iso9660::Exception("Can't write to a read-only image.");
+  }
+  ++generation_;
+  while (size > 0) {
+    const std::size_t location =
+        static_cast<std::size_t>(offset / iso9660::SECTOR_SIZE);
+    auto result = sectors_.find(location);
+    if (result == sectors_.end()) {
+      result = sectors_.emplace(location, Sector()).first;
+      result->second.written.fill(0);
+    }
+    auto& sector = result->second;
+    const std::size_t first = offset % iso9660::SECTOR_SIZE;
+    const std::size_t count = std::min(iso9660::SECTOR_SIZE - first, size);
+    std::memcpy(sector.data.data() + first, source, count);
+    sector.mark(first, count);
+    source += count;
+    offset += count;
+    size -= count;
+  }
+}
+
+std::uint64_t iso9660::Journal::capacity() const {
+  return sink_ == nullptr ? 0 : sink_->capacity();
+}
+
+/**
+ * Write all dirty sectors in ascending order and wait until they're stored as
+ * durably as requested.
+ */
+void iso9660::Journal::commit(iso9660::Durability durability) {
+  write_sectors(sectors_.begin(), sectors_.end(), durability);
+}
+
+/**
+ * Sectors outside of the section stay staged.
+ */
+void iso9660::Journal::commit(std::uint64_t offset, std::size_t size,
+                              iso9660::Durability durability) {
+  if (size == 0) return;
+  const auto first = sectors_.lower_bound(
+      static_cast<std::size_t>(offset / iso9660::SECTOR_SIZE));
+  const auto last = sectors_.lower_bound(static_cast<std::size_t>(
+      (offset + size + iso9660::SECTOR_SIZE - 1) / iso9660::SECTOR_SIZE));
+  if (first != last) write_sectors(first, last, durability);
+}
+
+/**
+ * Adjacent sectors are written at once. The sectors are forgotten afterwards.
+ */
+void iso9660::Journal::write_sectors(Sectors::iterator first,
+                                     Sectors::iterator last,
+                                     iso9660::Durability durability) {
+  if (sink_ == nullptr) return;
+  read_unwritten(first, last);
+  std::vector<iso9660::Span> run;
+  for (auto sector = first; sector != last;) {
+    run.clear();
+    auto end = sector;
+    std::size_t location = sector->first;
+    do {
+      run.emplace_back(end->second.data.data(), end->second.data.size());
+      ++end;
+      ++location;
+    } while (end != last && end->first == location);
+    sink_->write_vectored(
+        static_cast<std::uint64_t>(sector->first) * iso9660::SECTOR_SIZE,
+        run.data(), run.size());
+    sector = end;
+  }
+  sink_->sync(durability);
+  sectors_.erase(first, last);
+}
+
+void iso9660::Journal::discard() {
+  sectors_.clear();
+  ++generation_;
+}
+
+bool iso9660::Journal::empty() const { return sectors_.empty(); }
+
+std::size_t iso9660::Journal::dirty_sectors() const { return sectors_.size(); }
+
+/**
+ * Read whatever hasn't been written of the dirty sectors. Adjacent sectors are
+ * read at once. Whatever lies past the end of the image is zero.
+ */
+void iso9660::Journal::read_unwritten(Sectors::iterator first,
+                                      Sectors::iterator end) {
+  const std::uint64_t size = source_->size();
+  std::vector<iso9660::Byte> original;
+  while (first != end) {
+    if (first->second.complete()) {
+      ++first;
+      continue;
+    }
+    auto last = first;
+    std::size_t location = first->first;
+    do {
+      ++last;
+      ++location;
+    } while (last != end && last->first == location &&
+             !last->second.complete() &&
+             location - first->first < MAX_READ_SECTORS);
+    const std::uint64_t begin =
+        static_cast<std::uint64_t>(first->first) * iso9660::SECTOR_SIZE;
+    const std::uint64_t end = std::min<std::uint64_t>(
+        size, static_cast<std::uint64_t>(location) * iso9660::SECTOR_SIZE);
+    original.assign((location - first->first) * iso9660::SECTOR_SIZE, 0);
+    if (begin < end) {
+      source_->read(begin, static_cast<std::size_t>(end - begin),
+                    original.data());
+    }
+    for (auto sector = original.data(); first != last;
+         ++first, sector += iso9660::SECTOR_SIZE) {
+      first->second.fill(sector);
+    }
+  }
+}
+
+void iso9660::Journal::Sector::mark(std::size_t first, std::size_t count) {
+  const std::size_t last = first + count;
+  while (first < last) {
+    const std::size_t bit = first % WORD;
+    const std::size_t bits = std::min(WORD - bit, last - first);
+    const std::uint64_t mask =
+        bits == WORD ? ALL : ((static_cast<std::uint64_t>(1) << bits) - 1);
+    written[first / WORD] |= mask << bit;
+    first += bits;
+  }
+}
+
+bool iso9660::Journal::Sector::complete() const {
+  for (const auto word : written) {
+    if (word != ALL) return false;
+  }
+  return true;
+}
+
+/**
+ * Copy the written bytes of the given section of the sector.
+ */
+void iso9660::Journal::Sector::overlay(std::size_t first, std::size_t count,
+                                       iso9660::Byte* destination) const {
+  for (std::size_t i = first; i < first + count; ++i, ++destination) {
+    if (written[i / WORD] & (static_cast<std::uint64_t>(1) << (i % WORD))) {
+      *destination = data[i];
+    }
+  }
+}
+
+/**
+ * Take whatever hasn't been written from the original content of the sector.
+ */
+void iso9660::Journal::Sector::fill(const iso9660::Byte* original) {
+  for (std::size_t word = 0; word < written.size(); ++word) {
+    const std::uint64_t bits = written[word];
+    if (bits == ALL) continue;
+    const std::size_t first = word * WORD;
+    if (bits == 0) {
+      std::memcpy(data.data() + first, original + first, WORD);
+    } else {
+      for (std::size_t i = 0; i < WORD; ++i) {
+        if (!(bits & (static_cast<std::uint64_t>(1) << i))) {
+          data[first + i] = original[first + i];
+        }
+      }
+    }
+    written[word] = ALL;
+  }
+}
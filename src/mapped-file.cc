@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "./include/mapped-file.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include "./include/block-device.h"
+#include "./include/buffer.h"
+#include "./include/exception.h"
+
+#ifndef _WIN32
+iso9660::MappedFile::MappedFile(const std::string& path)
+    : data_(nullptr), size_(0) {
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw iso9660::Exception("Couldn't open " + path + ": " +
+                             std::strerror(errno));
+  }
+  struct stat status;
+  if (fstat(fd, &status) != 0) {
+    const int error = errno;
+    close(fd);
+    throw iso9660::Exception("Couldn't stat " + path + ": " +
+                             std::strerror(error));
+  }
+  size_ = static_cast<std::size_t>(status.st_size);
+  if (size_ < iso9660::SYSTEM_AREA_SIZE) {
+    close(fd);
+    throw iso9660::CorruptFileException(path + " is too small to be an image.");
+  }
+  void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping stays valid after the file descriptor has been closed.
+  const int error = errno;
+  close(fd);
+  if (data == MAP_FAILED) {
+    throw iso9660::Exception("Couldn't map " + path + ": " +
+                             std::strerror(error));
+  }
+  data_ = static_cast<const iso9660::Byte*>(data);
+}
+
+iso9660::MappedFile::~MappedFile() {
+  munmap(const_cast<iso9660::Byte*>(data_), size_);
+}
+#else
+iso9660::MappedFile::MappedFile(const std::string& path)
+    : data_(nullptr), size_(0) {
+  throw iso9660::NotImplementedException(
+      "Memory mapped images are not supported on this platform.");
+}
+
+iso9660::MappedFile::~MappedFile() {}
+#endif
+
+void iso9660::MappedFile::read(std::uint64_t offset, std::size_t size,
+                               iso9660::Byte* destination) const {
+  auto source = view(offset, size);
+  std::copy(source.begin(), source.end(), destination);
+}
+
+iso9660::Span iso9660::MappedFile::view(std::uint64_t offset,
+                                        std::size_t size) const {
+  if (offset > size_ || size > size_ - offset) {
+    throw iso9660::CorruptFileException("Unexpected end of image at byte " +
+                                        std::to_string(offset) + ".");
+  }
+  return iso9660::Span(data_ + offset, size);
+}
+
+/**
+ * madvise only takes whole pages so the section is widened to them.
+ */
+void iso9660::MappedFile::advise(std::uint64_t offset, std::size_t size,
+                                 iso9660::Access access) const {
+#ifndef _WIN32
+  if (offset >= size_) return;
+  size = static_cast<std::size_t>(
+      std::min<std::uint64_t>(size, size_ - offset));
+  const auto page = static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+  const std::uint64_t first = offset / page * page;
+  const int advice =
+      access == iso9660::Access::SEQUENTIAL ? MADV_SEQUENTIAL : MADV_WILLNEED;
+  madvise(const_cast<iso9660::Byte*>(data_) + first,
+          static_cast<std::size_t>(offset + size - first), advice);
+#endif
+}
+
+std::uint64_t iso9660::MappedFile::size() const { return size_; }
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "./include/name-arena.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "./include/exception.h"
+#include "./include/string-view.h"
+
+namespace {
+
+constexpr std::size_t CHUNK_BITS = 16;
+constexpr std::size_t CHUNK_SIZE = 1 << CHUNK_BITS;
+constexpr std::size_t MAX_CHUNKS = 1 << (32 - CHUNK_BITS);
+constexpr std::uint32_t EMPTY = 0xffffffff;
+// Must be a power of two.
+constexpr std::size_t INITIAL_SLOTS = 1024;
+/*
+ * Every stored name is prefixed by its length using two bytes. The longest
+ * name is a UTF-8 encoded Joliet name which is at most 381 bytes long.
+ */
+constexpr std::size_t PREFIX_SIZE = 2;
+
+}  // namespace
+
+iso9660::NameArena::NameArena()
+    : free_(nullptr),
+      available_(0),
+      bytes_(0),
+      slots_(INITIAL_SLOTS, EMPTY),
+      size_(0) {}
+
+iso9660::StringView iso9660::NameArena::intern(iso9660::StringView name) {
+  if (PREFIX_SIZE + name.size() > CHUNK_SIZE) {
+    throw iso9660::CorruptFileException("Name is too long.");
+  }
+  const std::size_t hash = std::hash<iso9660::StringView>()(name);
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Keep the load factor below three quarters.
+  if ((size_ + 1) * 4 > slots_.size() * 3) grow();
+  const std::size_t mask = slots_.size() - 1;
+  std::size_t slot = hash & mask;
+  for (; slots_[slot] != EMPTY; slot = (slot + 1) & mask) {
+    const auto candidate = view(slots_[slot]);
+    if (candidate == name) return candidate;
+  }
+  slots_[slot] = store(name);
+  ++size_;
+  return view(slots_[slot]);
+}
+
+std::size_t iso9660::NameArena::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return size_;
+}
+
+std::size_t iso9660::NameArena::bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return bytes_;
+}
+
+std::uint32_t iso9660::NameArena::store(iso9660::StringView name) {
+  const std::size_t size = PREFIX_SIZE + name.size();
+  if (size > available_) {
+    if (chunks_.size() == MAX_CHUNKS) {
+      throw iso9660::NotImplementedException("Too many names.");
+    }
+    chunks_.emplace_back(new char[CHUNK_SIZE]);
+    free_ = chunks_.back().get();
+    available_ = CHUNK_SIZE;
+  }
+  char* stored = free_;
+  stored[0] = static_cast<char>(name.size() >> 8);
+  stored[1] = static_cast<char>(name.size() & 0xff);
+  std::copy(name.begin(), name.end(), stored + PREFIX_SIZE);
+  free_ += size;
+  available_ -= size;
+  bytes_ += size;
+  const std::size_t offset = stored - chunks_.back().get();
+  return static_cast<std::uint32_t>(((chunks_.size() - 1) << CHUNK_BITS) |
+                                    offset);
+}
+
+iso9660::StringView iso9660::NameArena::view(std::uint32_t slot) const {
+  const char* stored =
+      chunks_[slot >> CHUNK_BITS].get() + (slot & (CHUNK_SIZE - 1));
+  const std::size_t size = (static_cast<unsigned char>(stored[0]) << 8) |
+                           static_cast<unsigned char>(stored[1]);
+  return iso9660::StringView(stored + PREFIX_SIZE, size);
+}
+
+void iso9660::NameArena::grow() {
+  std::vector<std::uint32_t> slots(slots_.size() * 2, EMPTY);
+  const std::size_t mask = slots.size() - 1;
+  std::hash<iso9660::StringView> hash;
+  for (std::uint32_t stored : slots_) {
+    if (stored == EMPTY) continue;
+    std::size_t slot = hash(view(stored)) & mask;
+    while (slots[slot] != EMPTY) slot = (slot + 1) & mask;
+    slots[slot] = stored;
+  }
+  slots_.swap(slots);
+}
@@ -21,50 +21,220 @@
 
 #include <algorithm>
 #include <iterator>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "./include/buffer.h"
+#include "./include/exception.h"
+#include "./include/layout.h"
+#include "./include/name-arena.h"
+#include "./include/string-view.h"
 #include "./include/utility.h"
 
 /**
  * Read path table record according to ECMA-119. Note that the path table is not
- * used anymore in ECMA-167.
+ * used anymore in ECMA-167. Joliet names are converted to UTF-8 right away.
  */
-iso9660::Directory::Directory(iso9660::Buffer::const_iterator first,
-                              iso9660::Buffer::const_iterator last) {
-  using utility::integer;
-  const auto length = static_cast<int>(utility::at(first, last, 0));
-  // 8 byte + length of name + padding.
-  size = 8 + length + (length % 2 == 0 ? 0 : 1);
-  utility::at(first, last, &extended_length, 1);
-  integer(&location, first + 2, 4);
-  integer(&parent, first + 6, 2);
-  name = utility::substr(first, last, 8, length);
+iso9660::Directory::Directory(iso9660::Span record,
+                              iso9660::NameArena* const names, bool joliet)
+    : loaded(false) {
+  const auto first = record.begin();
+  namespace layout = iso9660::layout::path_table_record;
+  const std::size_t length = layout::DirectoryIdentifierLength::read(first);
+  // Fixed part + length of name + padding.
+  size = layout::DIRECTORY_IDENTIFIER + length + (length % 2 == 0 ? 0 : 1);
+  extended_length = layout::ExtendedAttributeLength::read(first);
+  location = layout::Location::read(first);
+  parent = layout::Parent::read(first);
+  const auto raw = utility::view(first, layout::DIRECTORY_IDENTIFIER, length);
+  name = joliet ? utility::from_ucs2(raw, names) : names->intern(raw);
+}
+
+/**
+ * Find a file of this directory by name. The directory has to be loaded.
+ */
+iso9660::File iso9660::Directory::find(iso9660::StringView filename) {
+  if (filenames_.empty()) {
+    filenames_.reserve(files.size());
+    for (const auto file : files) filenames_.emplace(file.name(), file);
+  }
+  auto result = filenames_.find(filename);
+  if (result == filenames_.end()) return iso9660::File();
+  return result->second;
 }
 
 /**
  * Read path table according to ECMA-119. Note that the path table is
  * not used anymore in ECMA-167.
  */
-iso9660::PathTable::PathTable(iso9660::Buffer::const_iterator first,
-                              iso9660::Buffer::const_iterator last) {
-  std::size_t size = std::distance(first, last);
+iso9660::PathTable::PathTable(iso9660::Span table,
+                              iso9660::NameArena* const names, bool joliet)
+    : joliet_(joliet), indexed_(false) {
+  namespace layout = iso9660::layout::path_table_record;
+  const std::size_t size = table.size();
   for (std::size_t record_position = 0; record_position < size;) {
-    iso9660::Directory directory(first + record_position, last);
+    const std::size_t remaining = size - record_position;
+    /*
+     * Unlike directory records, path table records may cross sector
+     * boundaries. They only have to stay within the table.
+     */
+    if (remaining < layout::MIN_SIZE ||
+        layout::DIRECTORY_IDENTIFIER +
+                layout::DirectoryIdentifierLength::read(
+                    table.begin() + record_position) >
+            remaining) {
+      throw iso9660::CorruptFileException(
+          "Malformed path table record at byte " +
+          std::to_string(record_position) + " of path table.");
+    }
+    iso9660::Directory directory(table.subspan(record_position, remaining),
+                                 names, joliet);
     record_position += directory.size;
     directories.emplace_back(std::move(directory));
   }
 }
 
+bool iso9660::PathTable::is_joliet() const { return joliet_; }
+
+/**
+ * Look up a directory by its path, e.g. "/EFI/BOOT". This takes one lookup per
+ * path component.
+ *
+ * @return Index of the directory or the number of directories if there's no
+ * such directory.
+ */
+std::size_t iso9660::PathTable::resolve(iso9660::StringView path) {
+  if (directories.empty()) return 0;
+  if (!indexed_) build_index();
+  // The root directory always comes first.
+  std::size_t current = 0;
+  for (std::size_t first = 0; first < path.size();) {
+    const std::size_t last =
+        std::find(path.begin() + first, path.end(), '/') - path.begin();
+    if (last > first) {
+      const auto& subdirectories = directories[current].subdirectories;
+      auto result = subdirectories.find(path.substr(first, last - first));
+      if (result == subdirectories.end()) return directories.size();
+      current = result->second;
+    }
+    first = last + 1;
+  }
+  return current;
+}
+
+/**
+ * The directory of the other path table at the same path as each directory of
+ * this one. Names are compared as utility::comparable_name tells, so this
+ * works between the primary and the Joliet path table. Subdirectories of the
+ * same directory whose names have been cut short in one of the tables are
+ * matched by their order if the shorter name starts like the longer one. A
+ * directory without a single match is matched to the number of directories
+ * of the other table.
+ */
+std::vector<std::size_t> iso9660::PathTable::match(
+    const iso9660::PathTable& other) const {
+  const std::size_t none = other.directories.size();
+  std::vector<std::size_t> matches(directories.size(), none);
+  if (directories.empty() || other.directories.empty()) return matches;
+  std::vector<std::vector<std::size_t>> children(other.directories.size());
+  for (std::size_t i = 1; i < other.directories.size(); ++i) {
+    const auto parent =
+        static_cast<std::size_t>(other.directories[i].parent - 1);
+    if (parent < i) children[parent].emplace_back(i);
+  }
+  /*
+   * Parents come before their children in a path table and subdirectories of
+   * the same directory are listed one after another.
+   */
+  matches[0] = 0;
+  for (std::size_t first = 1, last; first < directories.size(); first = last) {
+    const int parent = directories[first].parent;
+    for (last = first;
+         last < directories.size() && directories[last].parent == parent;
+         ++last) {
+    }
+    const auto index = static_cast<std::size_t>(parent - 1);
+    if (index >= first || matches[index] == none) continue;
+    match_children(other, children[matches[index]], first, last, &matches);
+  }
+  return matches;
+}
+
+/**
+ * Match the directories [first, last) of this table, which have the same
+ * parent, to the given subdirectories of the matching directory of the other
+ * table.
+ */
+void iso9660::PathTable::match_children(
+    const iso9660::PathTable& other, const std::vector<std::size_t>& children,
+    std::size_t first, std::size_t last,
+    std::vector<std::size_t>* const matches) const {
+  const std::size_t none = other.directories.size();
+  /*
+   * The directory of each table with each name. The size of the table if
+   * there are several and one more than that if there's none.
+   */
+  const std::size_t several = directories.size();
+  std::map<std::string, std::pair<std::size_t, std::size_t>> names;
+  for (std::size_t i = first; i < last; ++i) {
+    auto inserted =
+        names.emplace(utility::comparable_name(directories[i].name),
+                      std::make_pair(i, none + 1));
+    if (!inserted.second) inserted.first->second.first = several;
+  }
+  for (const std::size_t child : children) {
+    auto name = names.find(
+        utility::comparable_name(other.directories[child].name));
+    if (name == names.end()) continue;
+    auto& pair = name->second;
+    pair.second = pair.second == none + 1 ? child : none;
+  }
+  std::vector<bool> matched(other.directories.size(), false);
+  for (const auto& name : names) {
+    const auto& pair = name.second;
+    if (pair.first >= several || pair.second >= none) continue;
+    (*matches)[pair.first] = pair.second;
+    matched[pair.second] = true;
+  }
+  // Whatever is left is matched in order of the names.
+  std::vector<std::pair<std::string, std::size_t>> left;
+  std::vector<std::pair<std::string, std::size_t>> other_left;
+  for (std::size_t i = first; i < last; ++i) {
+    if ((*matches)[i] != none) continue;
+    left.emplace_back(utility::comparable_name(directories[i].name), i);
+  }
+  for (const std::size_t child : children) {
+    if (matched[child]) continue;
+    other_left.emplace_back(
+        utility::comparable_name(other.directories[child].name), child);
+  }
+  if (left.size() != other_left.size()) return;
+  std::sort(left.begin(), left.end());
+  std::sort(other_left.begin(), other_left.end());
+  for (std::size_t i = 0; i < left.size(); ++i) {
+    const auto& name = left[i].first;
+    const auto& other_name = other_left[i].first;
+    const std::size_t size = std::min(name.size(), other_name.size());
+    if (size == 0 || name.compare(0, size, other_name, 0, size) != 0) continue;
+    (*matches)[left[i].second] = other_left[i].second;
+  }
+}
+
 /**
- * Post-process path table of supplementary volume descriptor that uses joliet.
+ * Link every directory to its parent. Path table records are numbered from
+ * one and the root directory is its own parent.
  */
-void iso9660::PathTable::joliet() {
-  for (auto& directory : directories) {
-    directory.name = utility::from_ucs2(std::move(directory.name));
-    for (auto& file : directory.files) {
-      if (!file.isdir()) {
-        file.name = utility::from_ucs2(std::move(file.name));
-      }
+void iso9660::PathTable::build_index() {
+  for (std::size_t i = 1; i < directories.size(); ++i) {
+    const auto parent = static_cast<std::size_t>(directories[i].parent);
+    if (parent == 0 || parent > directories.size()) {
+      throw iso9660::CorruptFileException(
+          "Path table record " + std::to_string(i + 1) +
+          " refers to a parent that does not exist.");
     }
+    directories[parent - 1].subdirectories.emplace(directories[i].name, i);
   }
+  indexed_ = true;
 }
@@ -20,62 +20,114 @@
 #include "./include/read.h"
 
 #include <cstdint>
-#include <ctime>
+#include <string>
 
 #include "./include/buffer.h"
-#include "./include/utility.h"
+#include "./include/exception.h"
+
+namespace {
+
+constexpr std::ptrdiff_t LONG_DATETIME_SIZE = 17;
+constexpr std::ptrdiff_t SHORT_DATETIME_SIZE = 7;
+
+void check_size(iso9660::Span::const_iterator first,
+                iso9660::Span::const_iterator last, std::ptrdiff_t size) {
+  if (last - first < size) {
+    throw iso9660::CorruptFileException(
+        "Datetime is " + std::to_string(last - first) +
+        " bytes long instead of " + std::to_string(size) + ".");
+  }
+}
+
+/**
+ * Number of days from 1970-01-01 to the given date of the proleptic Gregorian
+ * calendar. Years start in March so that the leap day is the last day of the
+ * year, see http://howardhinnant.github.io/date_algorithms.html.
+ */
+std::int64_t days_from_civil(std::int64_t year, unsigned month,
+                             unsigned day) {
+  year -= month <= 2;
+  const std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+  const auto year_of_era = static_cast<unsigned>(year - era * 400);
+  const unsigned day_of_year =
+      (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  const unsigned day_of_era =
+      year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+  return era * 146097 + static_cast<std::int64_t>(day_of_era) - 719468;
+}
+
+std::int64_t seconds_since_epoch(std::int64_t year, unsigned month,
+                                 unsigned day, unsigned hour, unsigned minute,
+                                 unsigned second) {
+  return days_from_civil(year, month, day) * 86400 + hour * 3600 +
+         minute * 60 + second;
+}
+
+/**
+ * Offset from Greenwich mean time in number of 15 minute intervals from -48
+ * (West) to +52 (East) stored as a signed byte.
+ */
+int offset_seconds(iso9660::Byte offset) {
+  return static_cast<std::int8_t>(offset) * 15 * 60;
+}
 
 /**
- * @return Datetime in milliseconds since epoch with up-to centisecond
+ * Parse decimal digits without any checks except for whether all of them are
+ * actually digits.
+ */
+unsigned digits(iso9660::Span::const_iterator first, std::size_t count,
+                bool* const valid) {
+  unsigned value = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    const unsigned digit = first[i] - static_cast<unsigned>('0');
+    *valid &= digit <= 9;
+    value = value * 10 + digit;
+  }
+  return value;
+}
+
+}  // namespace
+
+/**
+ * @return Datetime in milliseconds since epoch in UTC with up-to centisecond
  * precision. Therefore the timezone offset will be discarded but taken into
  * account.
  */
 std::int64_t iso9660::read::long_datetime(
-    iso9660::Buffer::const_iterator first,
-    iso9660::Buffer::const_iterator last) {
-  auto toint = [first, last](int pos, int count) {
-    /**
-     * The potential overhead of copying to string could be avoided by
-     * implementing an stoi function that accepts an iterator range.
-     */
-    return std::stoi(utility::substr(first, last, pos, count));
-  };
+    iso9660::Span::const_iterator first,
+    iso9660::Span::const_iterator last) {
+  check_size(first, last, LONG_DATETIME_SIZE);
+  bool valid = true;
   // Year from 1 to 9999.
-  int year = toint(0, 4);
-  /*
-   * The specification says that the date and time are not specified if all
-   * digits and the offset byte are zero.
-   * This implementation quickly aborts if it the year is zero since the
-   * specification requires the year to be in the range from 1 to 9999 this
-   * seems reasonable.
-   */
-  if (year == 0) return 0;
-  struct tm datetime;
-  datetime.tm_year = year - 1900;
+  const unsigned year = digits(first, 4, &valid);
   // Month of the year from 1 to 12.
-  datetime.tm_mon = toint(4, 2) - 1;
+  const unsigned month = digits(first + 4, 2, &valid);
   // Day of the month from 1 to 31.
-  datetime.tm_mday = toint(6, 2);
+  const unsigned day = digits(first + 6, 2, &valid);
   // Hour of the day from 0 to 23.
-  datetime.tm_hour = toint(8, 2);
+  const unsigned hour = digits(first + 8, 2, &valid);
   // Minute of the hour from 0 to 59.
-  datetime.tm_min = toint(10, 2);
+  const unsigned minute = digits(first + 10, 2, &valid);
   // Second of the minute from 0 to 59.
-  datetime.tm_sec = toint(12, 2);
-  datetime.tm_isdst = 0;
+  const unsigned second = digits(first + 12, 2, &valid);
   // Hundredths of a second.
-  std::int64_t milliseconds = toint(14, 2) * 10;
-  // Offset from UTC in number of 15 minute intervals from -48 (West) to +52
-  // (East).
-  int offset = static_cast<int>(
-                   static_cast<std::uint8_t>(utility::at(first, last, 16))) *
-               15;
-  std::int64_t seconds = mktime(&datetime) - offset * 60;
-  milliseconds += seconds * 1000;
-  return milliseconds;
+  const unsigned centiseconds = digits(first + 14, 2, &valid);
+  /*
+   * The specification says that the date and time are not specified if all
+   * digits and the offset byte are zero.
+   * This implementation quickly aborts if it the year is zero since the
+   * specification requires the year to be in the range from 1 to 9999 this
+   * seems reasonable. Some images fill unspecified fields with spaces
+   * instead, which is treated the same.
+   */
+  if (!valid || year == 0) return 0;
+  const std::int64_t seconds =
+      seconds_since_epoch(year, month, day, hour, minute, second) -
+      offset_seconds(first[16]);
+  return seconds * 1000 + centiseconds * 10;
 }
 
-std::int64_t iso9660::read::long_datetime(iso9660::Buffer::const_iterator first,
+std::int64_t iso9660::read::long_datetime(iso9660::Span::const_iterator first,
                                           std::size_t size) {
   return iso9660::read::long_datetime(first, first + size);
 }
@@ -91,28 +143,20 @@ std::int64_t iso9660::read::long_datetime(iso9660::Buffer::const_iterator first,
  * 7. byte: Offset from Greenwich mean time in number for 15 minute intervales
  * from -48 (West) to +52 (East).
  *
- * @return Datetime in seconds since epoch. Therefore the timezone offset will
- * be discarded but taken into * account.
+ * @return Datetime in seconds since epoch in UTC. Therefore the timezone
+ * offset will be discarded but taken into account.
  */
-int iso9660::read::short_datetime(iso9660::Buffer::const_iterator first,
-                                  iso9660::Buffer::const_iterator last) {
-  struct tm datetime;
-  utility::at(first, last, &datetime.tm_year, 0);
-  if (datetime.tm_year == 0) return 0;
-  utility::at(first, last, &datetime.tm_mon, 1);
-  datetime.tm_mon -= 1;
-  utility::at(first, last, &datetime.tm_mday, 2);
-  utility::at(first, last, &datetime.tm_hour, 3);
-  utility::at(first, last, &datetime.tm_min, 4);
-  utility::at(first, last, &datetime.tm_sec, 5);
-  datetime.tm_isdst = 0;
-  int offset =
-      static_cast<int>(static_cast<std::uint8_t>(utility::at(first, last, 6))) *
-      15;
-  return mktime(&datetime) - offset * 60;
+int iso9660::read::short_datetime(iso9660::Span::const_iterator first,
+                                  iso9660::Span::const_iterator last) {
+  check_size(first, last, SHORT_DATETIME_SIZE);
+  if (first[0] == 0) return 0;
+  return static_cast<int>(seconds_since_epoch(1900 + first[0], first[1],
+                                              first[2], first[3], first[4],
+                                              first[5]) -
+                          offset_seconds(first[6]));
 }
 
-int iso9660::read::short_datetime(iso9660::Buffer::const_iterator first,
+int iso9660::read::short_datetime(iso9660::Span::const_iterator first,
                                   std::size_t size) {
   return iso9660::read::short_datetime(first, first + size);
 }
@@ -0,0 +1,241 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "./include/sector-cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "./include/block-device.h"
+#include "./include/buffer.h"
+#include "./include/exception.h"
+
+iso9660::SectorCache::SectorCache(const iso9660::BlockSource* source,
+                                  iso9660::BlockSink* sink,
+                                  std::size_t capacity, std::size_t shards)
+    : source_(source),
+      sink_(sink),
+      end_(source->size()),
+      hits_(0),
+      misses_(0) {
+  shards = std::max<std::size_t>(shards, 1);
+  const std::size_t slots =
+      std::max<std::size_t>(capacity / iso9660::SECTOR_SIZE / shards, 1);
+  for (std::size_t i = 0; i < shards; ++i) {
+    shards_.emplace_back(new Shard());
+    auto& shard = *shards_.back();
+    shard.sectors.resize(slots);
+    shard.referenced.resize(slots);
+    shard.data.resize(slots * iso9660::SECTOR_SIZE);
+    shard.used = 0;
+    shard.hand = 0;
+  }
+  // Consecutive sectors are spread across all shards.
+  bypass_ = std::max(slots * shards * iso9660::SECTOR_SIZE / 4,
+                     iso9660::SECTOR_SIZE);
+}
+
+/**
+ * Missing sectors are read from the source in runs of consecutive sectors.
+ */
+void iso9660::SectorCache::read(std::uint64_t offset, std::size_t size,
+                                iso9660::Byte* destination) const {
+  if (size == 0) return;
+  const std::uint64_t first = offset / iso9660::SECTOR_SIZE;
+  const std::uint64_t last =
+      (offset + size + iso9660::SECTOR_SIZE - 1) / iso9660::SECTOR_SIZE;
+  if (size > bypass_ || last * iso9660::SECTOR_SIZE > end_) {
+    source_->read(offset, size, destination);
+    return;
+  }
+  const auto count = static_cast<std::size_t>(last - first);
+  // Whole sectors are read straight into the destination.
+  const bool aligned = offset % iso9660::SECTOR_SIZE == 0 &&
+                       size % iso9660::SECTOR_SIZE == 0;
+  std::vector<iso9660::Byte> buffer(aligned ? 0
+                                            : count * iso9660::SECTOR_SIZE);
+  const auto sectors = aligned ? destination : buffer.data();
+  auto at = [sectors](std::size_t i) {
+    return sectors + i * iso9660::SECTOR_SIZE;
+  };
+  for (std::size_t i = 0; i < count;) {
+    if (lookup(first + i, at(i))) {
+      ++i;
+      continue;
+    }
+    std::size_t run = 1;
+    bool hit = false;
+    while (i + run < count && !(hit = lookup(first + i + run, at(i + run)))) {
+      ++run;
+    }
+    source_->read((first + i) * iso9660::SECTOR_SIZE,
+                  run * iso9660::SECTOR_SIZE, at(i));
+    for (std::size_t j = i; j < i + run; ++j) insert(first + j, at(j));
+    misses_ += run;
+    i += hit ? run + 1 : run;
+  }
+  if (!aligned) {
+    const auto section = buffer.data() + (offset % iso9660::SECTOR_SIZE);
+    std::copy(section, section + size, destination);
+  }
+}
+
+iso9660::Span iso9660::SectorCache::view(std::uint64_t offset,
+                                         std::size_t size) const {
+  return source_->view(offset, size);
+}
+
+std::size_t iso9660::SectorCache::transfer(std::uint64_t offset,
+                                           std::size_t size, int fd) const {
+  return source_->transfer(offset, size, fd);
+}
+
+void iso9660::SectorCache::advise(std::uint64_t offset, std::size_t size,
+                                  iso9660::Access access) const {
+  source_->advise(offset, size, access);
+}
+
+std::uint64_t iso9660::SectorCache::size() const { return source_->size(); }
+
+void iso9660::SectorCache::write(std::uint64_t offset,
+                                 const iso9660::Byte* source,
+                                 std::size_t size) {
+  if (sink_ == nullptr) {
+    throw iso9660::Exception("Can't write to a read-only image.");
+  }
+  sink_->write(offset, source, size);
+  update(offset, source, size);
+}
+
+void iso9660::SectorCache::write_vectored(std::uint64_t offset,
+                                          const iso9660::Span* spans,
+                                          std::size_t count) {
+  if (sink_ == nullptr) {
+    throw iso9660::Exception("Can't write to a read-only image.");
+  }
+  sink_->write_vectored(offset, spans, count);
+  for (std::size_t i = 0; i < count; ++i) {
+    update(offset, spans[i].begin(), spans[i].size());
+    offset += spans[i].size();
+  }
+}
+
+void iso9660::SectorCache::sync(iso9660::Durability durability) {
+  if (sink_ != nullptr) sink_->sync(durability);
+}
+
+std::uint64_t iso9660::SectorCache::capacity() const {
+  return sink_ == nullptr ? 0 : sink_->capacity();
+}
+
+void iso9660::SectorCache::clear() {
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    shard->slots.clear();
+    shard->used = 0;
+    shard->hand = 0;
+  }
+  end_ = source_->size();
+}
+
+std::uint64_t iso9660::SectorCache::hits() const { return hits_; }
+
+std::uint64_t iso9660::SectorCache::misses() const { return misses_; }
+
+iso9660::SectorCache::Shard& iso9660::SectorCache::shard(
+    std::uint64_t sector) const {
+  return *shards_[static_cast<std::size_t>(sector % shards_.size())];
+}
+
+bool iso9660::SectorCache::lookup(std::uint64_t sector,
+                                  iso9660::Byte* destination) const {
+  auto& shard = this->shard(sector);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto result = shard.slots.find(sector);
+  if (result == shard.slots.end()) return false;
+  const std::size_t slot = result->second;
+  shard.referenced[slot] = true;
+  const auto data = shard.data.begin() + slot * iso9660::SECTOR_SIZE;
+  std::copy(data, data + iso9660::SECTOR_SIZE, destination);
+  ++hits_;
+  return true;
+}
+
+/**
+ * The clock hand skips sectors that have been read since it passed them last
+ * time and evicts the first one that hasn't.
+ */
+void iso9660::SectorCache::insert(std::uint64_t sector,
+                                  const iso9660::Byte* source) const {
+  auto& shard = this->shard(sector);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto result = shard.slots.find(sector);
+  std::size_t slot;
+  if (result != shard.slots.end()) {
+    slot = result->second;
+  } else if (shard.used < shard.sectors.size()) {
+    slot = shard.used++;
+  } else {
+    while (shard.referenced[shard.hand]) {
+      shard.referenced[shard.hand] = false;
+      shard.hand = (shard.hand + 1) % shard.sectors.size();
+    }
+    slot = shard.hand;
+    shard.hand = (shard.hand + 1) % shard.sectors.size();
+    shard.slots.erase(shard.sectors[slot]);
+  }
+  shard.sectors[slot] = sector;
+  shard.referenced[slot] = false;
+  shard.slots[sector] = slot;
+  std::copy(source, source + iso9660::SECTOR_SIZE,
+            shard.data.begin() + slot * iso9660::SECTOR_SIZE);
+}
+
+/**
+ * Written bytes are copied into the sectors that are cached. Sectors that
+ * aren't cached stay that way.
+ */
+void iso9660::SectorCache::update(std::uint64_t offset,
+                                  const iso9660::Byte* source,
+                                  std::size_t size) {
+  end_ = std::max<std::uint64_t>(end_, offset + size);
+  while (size > 0) {
+    const std::uint64_t sector = offset / iso9660::SECTOR_SIZE;
+    const auto within =
+        static_cast<std::size_t>(offset % iso9660::SECTOR_SIZE);
+    const std::size_t count = std::min(size, iso9660::SECTOR_SIZE - within);
+    auto& shard = this->shard(sector);
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      auto result = shard.slots.find(sector);
+      if (result != shard.slots.end()) {
+        std::memcpy(
+            shard.data.data() + result->second * iso9660::SECTOR_SIZE + within,
+            source, count);
+      }
+    }
+    offset += count;
+    source += count;
+    size -= count;
+  }
+}
@@ -20,64 +20,250 @@
 #include "./include/utility.h"
 
 #include <algorithm>
-#include <codecvt>
+#include <cstdint>
 #include <iterator>
-#include <locale>
 #include <string>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "./include/buffer.h"
+#include "./include/name-arena.h"
+#include "./include/string-view.h"
+
+namespace {
 
 /**
- * Convert from UCS-2 to UTF-8 string.
+ * Convert a single character or surrogate pair and advance past it. Unpaired
+ * surrogates become the replacement character.
  */
-std::string utility::from_ucs2(const std::u16string& from) {
-  static std::wstring_convert<std::codecvt_utf8<char16_t>, char16_t> convert;
-  return convert.to_bytes(from.c_str());
+char* ucs2_to_utf8(const unsigned char* const first, std::size_t size,
+                   std::size_t* const i, char* out) {
+  auto unit = [first](std::size_t at) {
+    return static_cast<std::uint32_t>(first[at * 2] << 8 | first[at * 2 + 1]);
+  };
+  std::uint32_t code_point = unit((*i)++);
+  if (code_point < 0x80) {
+    *out++ = static_cast<char>(code_point);
+    return out;
+  }
+  if (code_point < 0x800) {
+    *out++ = static_cast<char>(0xc0 | code_point >> 6);
+    *out++ = static_cast<char>(0x80 | (code_point & 0x3f));
+    return out;
+  }
+  if (code_point >= 0xd800 && code_point <= 0xdfff) {
+    if (code_point <= 0xdbff && *i < size && unit(*i) >= 0xdc00 &&
+        unit(*i) <= 0xdfff) {
+      code_point =
+          0x10000 + ((code_point - 0xd800) << 10) + (unit((*i)++) - 0xdc00);
+      *out++ = static_cast<char>(0xf0 | code_point >> 18);
+      *out++ = static_cast<char>(0x80 | (code_point >> 12 & 0x3f));
+      *out++ = static_cast<char>(0x80 | (code_point >> 6 & 0x3f));
+      *out++ = static_cast<char>(0x80 | (code_point & 0x3f));
+      return out;
+    }
+    code_point = 0xfffd;
+  }
+  *out++ = static_cast<char>(0xe0 | code_point >> 12);
+  *out++ = static_cast<char>(0x80 | (code_point >> 6 & 0x3f));
+  *out++ = static_cast<char>(0x80 | (code_point & 0x3f));
+  return out;
 }
 
+}  // namespace
+
 /**
- * Convert a raw string that actually uses UCS-2 big endian to UTF-8 string.
+ * Convert UCS-2 big endian to UTF-8. A trailing odd byte is ignored. The
+ * destination has to provide room for MAX_UTF8_PER_UCS2 bytes per character.
+ *
+ * Names are mostly ASCII so blocks of eight characters are checked at once and
+ * converted by just dropping the high bytes. Only characters that aren't ASCII
+ * are converted one by one.
+ *
+ * @return Number of bytes written.
  */
-std::string utility::from_ucs2(std::string&& raw) {
-  utility::big_endian(&raw);
-  raw += '\0';
-  std::u16string result(reinterpret_cast<const char16_t*>(raw.c_str()),
-                        raw.size() / 2);
-  return utility::from_ucs2(std::move(result));
+std::size_t utility::ucs2_to_utf8(const char* first, std::size_t size,
+                                  char* const destination) {
+  const auto bytes = reinterpret_cast<const unsigned char*>(first);
+  const std::size_t units = size / 2;
+  char* out = destination;
+  std::size_t i = 0;
+#ifdef __SSE2__
+  constexpr std::size_t BLOCK = 8;
+  // Loaded as little endian every character has its high byte at the bottom.
+  const __m128i non_ascii = _mm_set1_epi16(static_cast<short>(0x80ff));
+  const __m128i zero = _mm_setzero_si128();
+#endif
+  auto ascii = [bytes](std::size_t at) {
+    return bytes[at * 2] == 0 && bytes[at * 2 + 1] < 0x80;
+  };
+  while (i < units) {
+#ifdef __SSE2__
+    if (i + BLOCK <= units && ascii(i)) {
+      const __m128i block =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i * 2));
+      const int mask = _mm_movemask_epi8(
+          _mm_cmpeq_epi8(_mm_and_si128(block, non_ascii), zero));
+      const __m128i low = _mm_srli_epi16(block, 8);
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(out),
+                       _mm_packus_epi16(low, low));
+      // Keep the ASCII characters in front of the first other one.
+      const std::size_t prefix =
+          mask == 0xffff ? BLOCK : __builtin_ctz(~mask) / 2;
+      out += prefix;
+      i += prefix;
+      if (prefix == BLOCK) continue;
+    }
+#endif
+    // Runs of other characters are converted one by one up to the next ASCII.
+    do {
+      out = ::ucs2_to_utf8(bytes, units, &i, out);
+    } while (i < units && !ascii(i));
+  }
+  return out - destination;
 }
 
 /**
- * Correct byte order for our target system assuming that the current byte
- * order is big endian.
+ * Convert a raw string that actually uses UCS-2 big endian to UTF-8 and store
+ * it in the arena.
  */
-void utility::big_endian(std::string* const raw) {
-  if (ENDIANNESS == utility::Endian::BIG) return;
-  for (auto first = raw->begin(); first < raw->end(); first += 2) {
-    std::swap(*first, *(first + 1));
+iso9660::StringView utility::from_ucs2(iso9660::StringView raw,
+                                       iso9660::NameArena* const names) {
+  // Names of directory and path table records have at most 255 bytes.
+  constexpr std::size_t MAX_RAW_SIZE = 256;
+  char stack[MAX_RAW_SIZE / 2 * MAX_UTF8_PER_UCS2];
+  std::string heap;
+  char* destination = stack;
+  if (raw.size() > MAX_RAW_SIZE) {
+    heap.resize(raw.size() / 2 * MAX_UTF8_PER_UCS2);
+    destination = &heap[0];
   }
+  const std::size_t size = ucs2_to_utf8(raw.data(), raw.size(), destination);
+  return names->intern(iso9660::StringView(destination, size));
 }
 
 /**
- * Move a part of an array to a string.
- *
- * Since the ISO 9660 standard sometimes refers to values higher than 127 an
- * unsigned char is used to work directly with the read data so that the values
- * provided by ISO 9660 do not have to be converted to its signed 8 bit
- * equivalent by the user.
- *
- * When human readable data is stored we need to convert it back to char and
- * we'll copy it into a string so that it won't change if the data in the view
- * changes.
+ * Convert a UTF-8 name to UCS-2 stored in the big endian format as used by
+ * Joliet. Characters beyond the basic multilingual plane become surrogate
+ * pairs and invalid sequences become U+FFFD.
  */
-std::string utility::substr(iso9660::Buffer::const_iterator first,
-                            iso9660::Buffer::const_iterator last,
-                            std::size_t at, std::size_t size) {
-  return std::string(first + at, size == 0 ? last : (first + at + size));
+std::string utility::to_ucs2(iso9660::StringView name) {
+  std::string ucs2;
+  ucs2.reserve(name.size() * 2);
+  auto append = [&ucs2](std::uint32_t unit) {
+    ucs2 += static_cast<char>(unit >> 8);
+    ucs2 += static_cast<char>(unit & 0xff);
+  };
+  for (std::size_t i = 0; i < name.size();) {
+    const auto lead = static_cast<unsigned char>(name[i]);
+    std::size_t length = 1;
+    std::uint32_t code_point = lead;
+    if (lead >= 0xf0 && lead < 0xf5) {
+      length = 4;
+      code_point = lead & 0x07;
+    } else if (lead >= 0xe0) {
+      length = 3;
+      code_point = lead & 0x0f;
+    } else if (lead >= 0xc2) {
+      length = 2;
+      code_point = lead & 0x1f;
+    } else if (lead >= 0x80) {
+      length = 0;
+    }
+    for (std::size_t j = 1; j < length; ++j) {
+      const auto next = i + j < name.size()
+                            ? static_cast<unsigned char>(name[i + j])
+                            : 0;
+      if ((next & 0xc0) != 0x80) {
+        length = 0;
+        break;
+      }
+      code_point = (code_point << 6) | (next & 0x3f);
+    }
+    if (length == 0 || (code_point >= 0xd800 && code_point < 0xe000) ||
+        code_point > 0x10ffff) {
+      append(0xfffd);
+      i += 1;
+      continue;
+    }
+    if (code_point >= 0x10000) {
+      code_point -= 0x10000;
+      append(0xd800 | (code_point >> 10));
+      append(0xdc00 | (code_point & 0x3ff));
+    } else {
+      append(code_point);
+    }
+    i += length;
+  }
+  return ucs2;
 }
 
-iso9660::Buffer::value_type utility::at(iso9660::Buffer::const_iterator first,
-                                        iso9660::Buffer::const_iterator last,
-                                        std::size_t index) {
-  // Could do out of bounds check here.
-  return std::move(*(first + index));
+/**
+ * Derive a file or directory identifier of the primary volume descriptor from
+ * a name according to ECMA-119 7.5 and 7.6. Only d-characters are used and
+ * files get an extension and a version number, e.g. "ks.cfg" becomes
+ * "KS.CFG;1". Names are cut to 30 characters as for interchange level 2.
+ */
+std::string utility::to_d_characters(iso9660::StringView name,
+                                     bool directory) {
+  constexpr std::size_t MAX_SIZE = 30;
+  auto d_character = [](char character) {
+    if (character >= 'a' && character <= 'z') return character - 'a' + 'A';
+    if ((character >= 'A' && character <= 'Z') ||
+        (character >= '0' && character <= '9')) {
+      return static_cast<int>(character);
+    }
+    return static_cast<int>('_');
+  };
+  std::size_t separator = name.size();
+  if (!directory) {
+    for (std::size_t i = name.size(); i > 0; --i) {
+      if (name[i - 1] == '.') {
+        separator = i - 1;
+        break;
+      }
+    }
+  }
+  std::string identifier;
+  for (std::size_t i = 0; i < separator && identifier.size() < MAX_SIZE; ++i) {
+    identifier += static_cast<char>(d_character(name[i]));
+  }
+  if (directory) return identifier;
+  identifier += '.';
+  for (std::size_t i = separator + 1;
+       i < name.size() && identifier.size() < MAX_SIZE + 1; ++i) {
+    identifier += static_cast<char>(d_character(name[i]));
+  }
+  return identifier + ";1";
+}
+
+/**
+ * A name in the form that the primary and the Joliet identifier of the same
+ * file have in common, e.g. "KS_1.CFG" for both "ks-1.cfg" and "KS_1.CFG;1".
+ * Identifiers that have been cut short don't have it in common.
+ */
+std::string utility::comparable_name(iso9660::StringView name) {
+  std::string comparable;
+  for (const char character : name) {
+    if (character == ';') break;
+    if (character >= 'a' && character <= 'z') {
+      comparable += static_cast<char>(character - 'a' + 'A');
+    } else if ((character >= 'A' && character <= 'Z') ||
+               (character >= '0' && character <= '9') || character == '.') {
+      comparable += character;
+    } else {
+      comparable += '_';
+    }
+  }
+  if (!comparable.empty() && comparable.back() == '.') comparable.pop_back();
+  return comparable;
+}
+
+/**
+ * Refer to human readable data without copying it.
+ */
+iso9660::StringView utility::view(iso9660::Span::const_iterator first,
+                                  std::size_t at, std::size_t size) {
+  return iso9660::StringView(reinterpret_cast<const char*>(first + at), size);
 }
@@ -20,68 +20,196 @@
 #include "./include/volume-descriptor.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <iterator>
 #include <memory>
 #include <unordered_map>
 #include <utility>
 
 #include "./include/file.h"
 #include "./include/buffer.h"
-#include "./include/read.h"
-#include "./include/utility.h"
+#include "./include/exception.h"
+#include "./include/file-table.h"
+#include "./include/layout.h"
+#include "./include/name-arena.h"
+
+template <class Field>
+typename Field::type iso9660::VolumeDescriptor::field() const {
+  return Field::read(sector_.data());
+}
+
+template <class Field>
+std::int64_t iso9660::VolumeDescriptor::datetime(Datetime which) const {
+  if (!decoded_[which]) {
+    datetimes_[which] = field<Field>();
+    decoded_[which] = true;
+  }
+  return datetimes_[which];
+}
 
 /**
  * Read primary or supplementary volume descriptor according to ECMA-119.
  */
 iso9660::VolumeDescriptor::VolumeDescriptor(
-    iso9660::Buffer::const_iterator first, iso9660::Buffer::const_iterator last,
-    iso9660::VolumeDescriptorHeader generic_header) {
-  constexpr std::size_t APPLICATION_USE_SIZE = 512;
-  constexpr std::size_t DIRECTORY_RECORD_SIZE = 34;
-  constexpr std::size_t FILE_IDENTIFIER_SIZE = 37;
-  constexpr std::size_t IDENTIFIER_SIZE = 128;
-  constexpr std::size_t LONG_DATETIME_SIZE = 17;
-  using utility::integer;
-  namespace read = iso9660::read;
-
-  header = std::move(generic_header);
-  if (header.type == iso9660::SectorType::SUPPLEMENTARY)
-    utility::at(first, last, &flags, 7);
-  system_identifier = utility::substr(first, last, 8, 32);
-  volume_identifier = utility::substr(first, last, 40, 32);
-  if (header.type == iso9660::SectorType::SUPPLEMENTARY)
-    escape_sequences = utility::substr(first, last, 88, 32);
-
-  integer(&volume_space_size, first + 80, first + 84, 4);
-  integer(&volume_sequence_number, first + 124, first + 126, 2);
-  integer(&logical_block_size, first + 128, first + 130, 2);
-  integer(&path_table_size, first + 132, first + 136, 4);
-  /*
-   * As specified in 6.9.2 there're actually two path tables which store the
-   * same information but using different endianness.
-   */
-  integer(&path_table_location, first + 140, first + 148, 4);
-  integer(&optional_path_table_location, first + 144, first + 152, 4);
-
-  root_directory = std::unique_ptr<iso9660::File>(
-      new iso9660::File(first + 156, DIRECTORY_RECORD_SIZE));
-  volume_set_identifier = utility::substr(first, last, 190, IDENTIFIER_SIZE);
-  publisher_identifier = utility::substr(first, last, 318, IDENTIFIER_SIZE);
-  data_preparer_identifier = utility::substr(first, last, 446, IDENTIFIER_SIZE);
-  application_identifier = utility::substr(first, last, 574, IDENTIFIER_SIZE);
-  copyright_file_identifier =
-      utility::substr(first, last, 702, FILE_IDENTIFIER_SIZE);
-  abstract_file_identifier =
-      utility::substr(first, last, 739, FILE_IDENTIFIER_SIZE);
-  bibliographic_file_identifier =
-      utility::substr(first, last, 776, FILE_IDENTIFIER_SIZE);
-  volume_create_datetime = read::long_datetime(first + 813, LONG_DATETIME_SIZE);
-  volume_modify_datetime = read::long_datetime(first + 830, LONG_DATETIME_SIZE);
-  volume_expiration_datetime =
-      read::long_datetime(first + 847, LONG_DATETIME_SIZE);
-  volume_effective_datetime =
-      read::long_datetime(first + 864, LONG_DATETIME_SIZE);
-  utility::at(first, last, &file_structure_version, 881);
-  application_use = utility::substr(first, last, 883, APPLICATION_USE_SIZE);
+    iso9660::Span descriptor, std::size_t location,
+    iso9660::VolumeDescriptorHeader generic_header,
+    iso9660::NameArena* const names)
+    : header(std::move(generic_header)), location(location) {
+  namespace layout = iso9660::layout::volume_descriptor;
+  std::copy(descriptor.begin(), descriptor.begin() + sector_.size(),
+            sector_.begin());
+  std::fill(std::begin(decoded_), std::end(decoded_), false);
+  root_directory = iso9660::File(
+      &root_record,
+      root_record.append(field<layout::RootDirectoryRecord>(), names, 0,
+                         joliet_level() > 0,
+                         static_cast<std::uint64_t>(location) *
+                                 iso9660::SECTOR_SIZE +
+                             layout::RootDirectoryRecord::OFFSET));
+}
+
+iso9660::Span iso9660::VolumeDescriptor::sector() const {
+  return iso9660::Span(sector_.data(), sector_.size());
+}
+
+void iso9660::VolumeDescriptor::set_volume_space_size(std::size_t size) {
+  iso9660::layout::volume_descriptor::VolumeSpaceSize::write(
+      sector_.data(),
+      static_cast<iso9660::layout::volume_descriptor::VolumeSpaceSize::type>(
+          size));
+}
+
+/**
+ * The root directory record of the retained sector refers to the given extent.
+ * The root directory of this instance isn't changed.
+ */
+void iso9660::VolumeDescriptor::set_root_directory(std::size_t location,
+                                                   std::size_t size) {
+  namespace layout = iso9660::layout;
+  auto record =
+      sector_.data() + layout::volume_descriptor::RootDirectoryRecord::OFFSET;
+  layout::directory_record::Location::write(
+      record,
+      static_cast<layout::directory_record::Location::type>(location));
+  layout::directory_record::DataLength::write(
+      record, static_cast<layout::directory_record::DataLength::type>(size));
+}
+
+int iso9660::VolumeDescriptor::flags() const {
+  return field<iso9660::layout::volume_descriptor::VolumeFlags>();
+}
+
+iso9660::StringView iso9660::VolumeDescriptor::system_identifier() const {
+  return field<iso9660::layout::volume_descriptor::SystemIdentifier>();
+}
+
+iso9660::StringView iso9660::VolumeDescriptor::volume_identifier() const {
+  return field<iso9660::layout::volume_descriptor::VolumeIdentifier>();
+}
+
+std::size_t iso9660::VolumeDescriptor::volume_space_size() const {
+  return field<iso9660::layout::volume_descriptor::VolumeSpaceSize>();
+}
+
+iso9660::StringView iso9660::VolumeDescriptor::escape_sequences() const {
+  return field<iso9660::layout::volume_descriptor::EscapeSequences>();
+}
+
+std::size_t iso9660::VolumeDescriptor::volume_set_size() const {
+  return field<iso9660::layout::volume_descriptor::VolumeSetSize>();
+}
+
+std::size_t iso9660::VolumeDescriptor::volume_sequence_number() const {
+  return field<iso9660::layout::volume_descriptor::VolumeSequenceNumber>();
+}
+
+std::size_t iso9660::VolumeDescriptor::logical_block_size() const {
+  return field<iso9660::layout::volume_descriptor::LogicalBlockSize>();
+}
+
+std::size_t iso9660::VolumeDescriptor::path_table_size() const {
+  return field<iso9660::layout::volume_descriptor::PathTableSize>();
+}
+
+std::size_t iso9660::VolumeDescriptor::type_l_path_table_location() const {
+  return field<iso9660::layout::volume_descriptor::TypeLPathTableLocation>();
+}
+
+std::size_t iso9660::VolumeDescriptor::optional_type_l_path_table_location()
+    const {
+  return field<
+      iso9660::layout::volume_descriptor::OptionalTypeLPathTableLocation>();
+}
+
+std::size_t iso9660::VolumeDescriptor::path_table_location() const {
+  return field<iso9660::layout::volume_descriptor::TypeMPathTableLocation>();
+}
+
+std::size_t iso9660::VolumeDescriptor::optional_path_table_location() const {
+  return field<
+      iso9660::layout::volume_descriptor::OptionalTypeMPathTableLocation>();
+}
+
+iso9660::StringView iso9660::VolumeDescriptor::volume_set_identifier() const {
+  return field<iso9660::layout::volume_descriptor::VolumeSetIdentifier>();
+}
+
+iso9660::StringView iso9660::VolumeDescriptor::publisher_identifier() const {
+  return field<iso9660::layout::volume_descriptor::PublisherIdentifier>();
+}
+
+iso9660::StringView iso9660::VolumeDescriptor::data_preparer_identifier()
+    const {
+  return field<iso9660::layout::volume_descriptor::DataPreparerIdentifier>();
+}
+
+iso9660::StringView iso9660::VolumeDescriptor::application_identifier() const {
+  return field<iso9660::layout::volume_descriptor::ApplicationIdentifier>();
+}
+
+iso9660::StringView iso9660::VolumeDescriptor::copyright_file_identifier()
+    const {
+  return field<iso9660::layout::volume_descriptor::CopyrightFileIdentifier>();
+}
+
+iso9660::StringView iso9660::VolumeDescriptor::abstract_file_identifier()
+    const {
+  return field<iso9660::layout::volume_descriptor::AbstractFileIdentifier>();
+}
+
+iso9660::StringView iso9660::VolumeDescriptor::bibliographic_file_identifier()
+    const {
+  return field<
+      iso9660::layout::volume_descriptor::BibliographicFileIdentifier>();
+}
+
+std::int64_t iso9660::VolumeDescriptor::volume_create_datetime() const {
+  return datetime<iso9660::layout::volume_descriptor::VolumeCreationDatetime>(
+      CREATE);
+}
+
+std::int64_t iso9660::VolumeDescriptor::volume_modify_datetime() const {
+  return datetime<
+      iso9660::layout::volume_descriptor::VolumeModificationDatetime>(MODIFY);
+}
+
+std::int64_t iso9660::VolumeDescriptor::volume_expiration_datetime() const {
+  return datetime<
+      iso9660::layout::volume_descriptor::VolumeExpirationDatetime>(
+      EXPIRATION);
+}
+
+std::int64_t iso9660::VolumeDescriptor::volume_effective_datetime() const {
+  return datetime<iso9660::layout::volume_descriptor::VolumeEffectiveDatetime>(
+      EFFECTIVE);
+}
+
+int iso9660::VolumeDescriptor::file_structure_version() const {
+  return field<iso9660::layout::volume_descriptor::FileStructureVersion>();
+}
+
+iso9660::StringView iso9660::VolumeDescriptor::application_use() const {
+  return field<iso9660::layout::volume_descriptor::ApplicationUse>();
 }
 
 /**
@@ -89,14 +217,33 @@ iso9660::VolumeDescriptor::VolumeDescriptor(
  */
 void iso9660::VolumeDescriptor::build_file_lookup() {
   for (const auto& directory : path_table->directories) {
-    for (const auto& file : directory.files) {
+    for (const auto file : directory.files) {
       if (!file.isdir()) {
-        filenames.emplace(file.name, &file);
+        filenames.emplace(file.name(), file);
       }
     }
   }
 }
 
+/**
+ * Make sure that both halves of every both-endian field of a primary or
+ * supplementary volume descriptor agree.
+ */
+void iso9660::VolumeDescriptor::check_both_endian(iso9660::Span descriptor) {
+  namespace layout = iso9660::layout::volume_descriptor;
+  const auto first = descriptor.begin();
+  if (!layout::VolumeSpaceSize::consistent(first) ||
+      !layout::VolumeSetSize::consistent(first) ||
+      !layout::VolumeSequenceNumber::consistent(first) ||
+      !layout::LogicalBlockSize::consistent(first) ||
+      !layout::PathTableSize::consistent(first)) {
+    throw iso9660::CorruptFileException(
+        "Both-endian fields of a volume descriptor disagree.");
+  }
+  iso9660::FileTable::check_both_endian(
+      layout::RootDirectoryRecord::read(first));
+}
+
 int iso9660::VolumeDescriptor::joliet_level() const {
   /*
    * The Joliet specification does not specify what the difference between the
@@ -105,6 +252,9 @@ int iso9660::VolumeDescriptor::joliet_level() const {
    */
   static std::unordered_map<char, int> joliet_level{
       {'@', 1}, {'C', 2}, {'E', 3}};
+  // Only supplementary volume descriptors have escape sequences.
+  if (header.type != iso9660::SectorType::SUPPLEMENTARY) return 0;
+  const auto escape_sequences = this->escape_sequences();
   if (escape_sequences[0] == '%' && escape_sequences[1] == '/' &&
       escape_sequences[3] == '\0') {
     auto level = joliet_level.find(escape_sequences[2]);
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "./include/write.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "./include/buffer.h"
+#include "./include/layout.h"
+#include "./include/string-view.h"
+
+namespace {
+
+struct Civil {
+  std::int64_t year;
+  unsigned month;
+  unsigned day;
+};
+
+/**
+ * Date of the proleptic Gregorian calendar that is the given number of days
+ * after 1970-01-01. The inverse of days_from_civil in read.cc, see
+ * http://howardhinnant.github.io/date_algorithms.html.
+ */
+Civil civil_from_days(std::int64_t days) {
+  days += 719468;
+  const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  const auto day_of_era = static_cast<unsigned>(days - era * 146097);
+  const unsigned year_of_era = (day_of_era - day_of_era / 1460 +
+                                day_of_era / 36524 - day_of_era / 146096) /
+                               365;
+  const unsigned day_of_year =
+      day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+  const unsigned shifted_month = (5 * day_of_year + 2) / 153;
+  Civil civil;
+  civil.day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+  civil.month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+  civil.year = year_of_era + era * 400 + (civil.month <= 2);
+  return civil;
+}
+
+/**
+ * Split seconds since epoch into a date and the seconds of that day.
+ */
+Civil split(std::int64_t seconds, unsigned* const second_of_day) {
+  std::int64_t days = seconds / 86400;
+  std::int64_t remainder = seconds % 86400;
+  if (remainder < 0) {
+    remainder += 86400;
+    --days;
+  }
+  *second_of_day = static_cast<unsigned>(remainder);
+  return civil_from_days(days);
+}
+
+void digits(unsigned value, std::size_t count, iso9660::Byte* const first) {
+  for (std::size_t i = count; i > 0; --i) {
+    first[i - 1] = static_cast<iso9660::Byte>('0' + value % 10);
+    value /= 10;
+  }
+}
+
+}  // namespace
+
+/**
+ * Record milliseconds since epoch as date and time in UTC according to
+ * ECMA-119 8.4.26.1. Zero means that the date and time are not specified.
+ */
+void iso9660::write::long_datetime(std::int64_t datetime,
+                                   iso9660::Byte* const first) {
+  if (datetime == 0) {
+    digits(0, 16, first);
+    first[16] = 0;
+    return;
+  }
+  std::int64_t milliseconds = datetime % 1000;
+  std::int64_t seconds = datetime / 1000;
+  if (milliseconds < 0) {
+    milliseconds += 1000;
+    --seconds;
+  }
+  unsigned second_of_day;
+  const Civil civil = split(seconds, &second_of_day);
+  digits(static_cast<unsigned>(civil.year), 4, first);
+  digits(civil.month, 2, first + 4);
+  digits(civil.day, 2, first + 6);
+  digits(second_of_day / 3600, 2, first + 8);
+  digits(second_of_day / 60 % 60, 2, first + 10);
+  digits(second_of_day % 60, 2, first + 12);
+  digits(static_cast<unsigned>(milliseconds / 10), 2, first + 14);
+  first[16] = 0;
+}
+
+/**
+ * Record seconds since epoch as date and time in UTC according to ECMA-119
+ * 9.1.5. Zero means that the date and time are not specified.
+ */
+void iso9660::write::short_datetime(int datetime, iso9660::Byte* const first) {
+  if (datetime == 0) {
+    for (std::size_t i = 0; i < 7; ++i) first[i] = 0;
+    return;
+  }
+  unsigned second_of_day;
+  const Civil civil = split(datetime, &second_of_day);
+  first[0] = static_cast<iso9660::Byte>(civil.year - 1900);
+  first[1] = static_cast<iso9660::Byte>(civil.month);
+  first[2] = static_cast<iso9660::Byte>(civil.day);
+  first[3] = static_cast<iso9660::Byte>(second_of_day / 3600);
+  first[4] = static_cast<iso9660::Byte>(second_of_day / 60 % 60);
+  first[5] = static_cast<iso9660::Byte>(second_of_day % 60);
+  first[6] = 0;
+}
+
+/**
+ * Create a directory record according to ECMA-119 9.1 that belongs to the
+ * first volume of the volume set and has no extended attribute record.
+ */
+std::vector<iso9660::Byte> iso9660::write::directory_record(
+    std::size_t location, std::size_t size, int datetime, int flags,
+    iso9660::StringView identifier) {
+  namespace layout = iso9660::layout::directory_record;
+  const std::size_t length = layout::FILE_IDENTIFIER + identifier.size();
+  // Records always start at an even byte.
+  std::vector<iso9660::Byte> record(length + length % 2, 0);
+  const auto first = record.data();
+  layout::Length::write(first,
+                        static_cast<layout::Length::type>(record.size()));
+  layout::Location::write(first,
+                          static_cast<layout::Location::type>(location));
+  layout::DataLength::write(first, static_cast<layout::DataLength::type>(size));
+  layout::RecordingDatetime::write(first, datetime);
+  layout::Flags::write(first, static_cast<layout::Flags::type>(flags));
+  layout::VolumeSequenceNumber::write(first, 1);
+  using IdentifierLength = layout::FileIdentifierLength;
+  IdentifierLength::write(
+      first, static_cast<IdentifierLength::type>(identifier.size()));
+  std::copy(identifier.begin(), identifier.end(),
+            first + layout::FILE_IDENTIFIER);
+  return record;
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+/*
+ * Files that are added and removed are found in both volume descriptors once
+ * the image has been written and read again. The primary name of the
+ * directory files are added to has been cut short. Anything that can't be
+ * added is refused right away and a write that fails leaves the image alone.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "./include/iso9660.h"
+#include "./test/helpers.h"
+
+namespace {
+
+// Content that is too large to be added. It's never read.
+class HugeSource : public iso9660::BlockSource {
+ public:
+  void read(std::uint64_t, std::size_t, iso9660::Byte*) const override {
+    throw iso9660::Exception("Huge content has been read.");
+  }
+  std::uint64_t size() const override { return std::uint64_t(1) << 32; }
+};
+
+std::string content(iso9660::Image* image, const std::string& path) {
+  std::string read;
+  const iso9660::File file = image->find(path);
+  test::expect(static_cast<bool>(file), path + " exists");
+  if (!file) return read;
+  image->read_file(file, [&read](iso9660::Span chunk) {
+    read.append(chunk.begin(), chunk.end());
+  });
+  return read;
+}
+
+bool has_primary_name(iso9660::Image* image, const std::string& name) {
+  for (const auto& primary_name : image->files().primary_names) {
+    if (primary_name.str() == name) return true;
+  }
+  return false;
+}
+
+template <typename Exception>
+void expect_refused(iso9660::Image* image, const std::string& path,
+                    const iso9660::BlockSource* content,
+                    const std::string& message) {
+  bool thrown = false;
+  try {
+    image->add_file(path, content);
+  } catch (const Exception&) {
+    thrown = true;
+  }
+  test::expect(thrown, message);
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <directories.iso> <copy.iso>\n"
+              << std::flush;
+    return 1;
+  }
+  const std::string text = "new\n";
+  iso9660::MemoryDevice added(
+      reinterpret_cast<const iso9660::Byte*>(text.data()), text.size());
+  HugeSource huge;
+  test::copy_file(argv[1], argv[2]);
+  {
+    std::fstream isofile(argv[2],
+                         std::ios::binary | std::ios::in | std::ios::out);
+    iso9660::Image image(&isofile);
+    image.read();
+    expect_refused<iso9660::NotImplementedException>(
+        &image, "/nowhere/file.txt", &added,
+        "Adding to a directory that doesn't exist throws");
+    expect_refused<iso9660::Exception>(
+        &image, "/longdirectoryname/a-b.txt", &added,
+        "Adding a name that exists in the primary volume descriptor throws");
+    expect_refused<iso9660::NotImplementedException>(
+        &image, "/longdirectoryname/huge.bin", &huge,
+        "Adding a file of 4 GiB throws");
+    image.add_file("/longdirectoryname/new-file.txt", &added);
+    expect_refused<iso9660::Exception>(
+        &image, "/longdirectoryname/new_file.txt", &added,
+        "Adding the same primary name twice throws");
+    image.remove_file(image.find("/readme.txt"));
+    image.write();
+    test::expect(content(&image, "/longdirectoryname/new-file.txt") == text,
+                 "The added file can be read right after writing");
+  }
+  {
+    std::fstream isofile(argv[2], std::ios::binary | std::ios::in);
+    iso9660::Image image(&isofile);
+    image.read();
+    test::expect(content(&image, "/longdirectoryname/new-file.txt") == text,
+                 "The added file can be read");
+    test::expect(image.find("/longdirectoryname/new-file.txt")
+                         .primary_name()
+                         .str() == "NEW_FILE.TXT;1",
+                 "The added file is in the primary volume descriptor");
+    test::expect(!image.find("/readme.txt"), "/readme.txt has been removed");
+    test::expect(!has_primary_name(&image, "README.TXT;1"),
+                 "README.TXT;1 has been removed");
+    test::expect(content(&image, "/longdirectoryname/a_b.txt") ==
+                     "underscore\n",
+                 "/longdirectoryname/a_b.txt is intact");
+    test::expect(content(&image, "/sub/file.txt") == "file\n",
+                 "/sub/file.txt is intact");
+  }
+
+  // An image in memory can't grow so adding a file fails when it's written.
+  std::ifstream isofile(argv[1], std::ios::binary);
+  std::vector<iso9660::Byte> original((std::istreambuf_iterator<char>(isofile)),
+                                      std::istreambuf_iterator<char>());
+  std::vector<iso9660::Byte> memory(original);
+  iso9660::MemoryDevice device(memory.data(), memory.size());
+  iso9660::Image image(&device, &device);
+  image.read();
+  image.modify_file(
+      image.find("/sub/file.txt"),
+      [](iso9660::BlockSink* sink, const iso9660::File& file) {
+        const char changed[] = "FILE";
+        sink->write(static_cast<std::uint64_t>(file.location()) *
+                            iso9660::SECTOR_SIZE +
+                        file.extended_length(),
+                    reinterpret_cast<const iso9660::Byte*>(changed),
+                    std::strlen(changed));
+        return std::streamsize(0);
+      });
+  image.add_file("/sub/added.txt", &added);
+  image.remove_file(image.find("/readme.txt"));
+  bool thrown = false;
+  try {
+    image.write();
+  } catch (const iso9660::NotImplementedException&) {
+    thrown = true;
+  }
+  test::expect(thrown, "Writing more than fits into memory throws");
+  test::expect(memory == original, "The image in memory is unchanged");
+  test::expect(content(&image, "/sub/file.txt") == "file\n",
+               "The staged modification has been dropped");
+  test::expect(static_cast<bool>(image.find("/readme.txt")),
+               "/readme.txt is still there");
+  image.write();
+  test::expect(memory == original, "Writing again doesn't change anything");
+  return test::result();
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+/*
+ * ECMA-119 tells the length of an extended attribute record in logical blocks.
+ * The data of a file starts right after it, so every way of reading a file
+ * has to skip it.
+ */
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <ios>
+#include <iostream>
+#include <string>
+
+#include "./include/iso9660.h"
+#include "./test/helpers.h"
+
+namespace {
+
+void expect_content(iso9660::Image* image, const std::string& path,
+                    const std::string& content) {
+  const iso9660::File file = image->find(path);
+  test::expect(static_cast<bool>(file), path + " exists");
+  if (!file) return;
+
+  std::string read;
+  image->read_file(file, [&read](iso9660::Span chunk) {
+    read.append(chunk.begin(), chunk.end());
+  });
+  test::expect(read == content, "read_file reads " + path);
+
+  std::string buffer(content.size(), '\0');
+  auto reader = image->reader(file);
+  const std::size_t count = reader.read(
+      0, buffer.size(), reinterpret_cast<iso9660::Byte*>(&buffer[0]));
+  test::expect(count == content.size() && buffer == content,
+               "FileReader reads " + path);
+
+  std::FILE* extracted = std::tmpfile();
+  test::expect(image->extract(file, fileno(extracted)) == content.size(),
+               "extract tells the size of " + path);
+  std::string written(content.size() + 1, '\0');
+  const ssize_t size = ::pread(fileno(extracted), &written[0],
+                               written.size(), 0);
+  std::fclose(extracted);
+  test::expect(size >= 0 &&
+                   written.substr(0, static_cast<std::size_t>(size)) ==
+                       content,
+               "extract writes " + path);
+
+  const std::size_t blocks = path == "/two.txt" ? 2 : path == "/one.txt";
+  test::expect(file.extended_length() == blocks * iso9660::SECTOR_SIZE,
+               "The extended attribute record of " + path + " is " +
+                   std::to_string(file.extended_length()) + " bytes long");
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  if (argc != 2) {
+    std::cerr << "Usage: " << argv[0] << " <extended-attributes.iso>\n"
+              << std::flush;
+    return 1;
+  }
+  std::fstream isofile(argv[1], std::ios::binary | std::ios::in);
+  iso9660::Image image(&isofile);
+  image.read();
+  expect_content(&image, "/none.txt", "no blocks\n");
+  expect_content(&image, "/one.txt", "one block\n");
+  expect_content(&image, "/two.txt", "two blocks\n");
+  return test::result();
+}
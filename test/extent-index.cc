@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+/*
+ * Queries of the extent index see files that have been resized or relocated
+ * before the image is written and give the same answers after it has been
+ * read again.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <ios>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "./include/iso9660.h"
+#include "./test/helpers.h"
+
+namespace {
+
+std::string overlapping(iso9660::Image* image, std::size_t first,
+                        std::size_t last) {
+  std::vector<std::string> names;
+  for (const auto& file : image->overlapping(first, last)) {
+    names.emplace_back(file.name().str());
+  }
+  std::sort(names.begin(), names.end());
+  std::string joined;
+  for (const auto& name : names) joined += (joined.empty() ? "" : " ") + name;
+  return joined;
+}
+
+void expect_overlapping(iso9660::Image* image, std::size_t first,
+                        std::size_t last, const std::string& expected,
+                        const std::string& when) {
+  const std::string found = overlapping(image, first, last);
+  test::expect(found == expected,
+               "Sectors [" + std::to_string(first) + ", " +
+                   std::to_string(last) + ") hold \"" + found +
+                   "\" instead of \"" + expected + "\" " + when);
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <shared-extent.iso> <copy.iso>\n"
+              << std::flush;
+    return 1;
+  }
+  test::copy_file(argv[1], argv[2]);
+  std::size_t readme = 0;
+  std::size_t other = 0;
+  {
+    std::fstream isofile(argv[2],
+                         std::ios::binary | std::ios::in | std::ios::out);
+    iso9660::Image image(&isofile);
+    image.read();
+    readme = image.find("/readme.txt").location();
+    other = image.find("/other.txt").location();
+    expect_overlapping(&image, readme, readme + 1, "readme.txt same.txt",
+                       "at first");
+    expect_overlapping(&image, other, other + 1, "other.txt", "at first");
+
+    image.modify_file(image.find("/readme.txt"),
+                      [](iso9660::FileStream* stream, const iso9660::File&) {
+                        stream->truncate(0);
+                      });
+    expect_overlapping(&image, readme, readme + 1, "same.txt",
+                       "after truncating readme.txt");
+
+    test::expect(image.relocate_file(image.find("/other.txt"), 5000),
+                 "/other.txt is relocated");
+    const std::size_t from = other;
+    other = image.find("/other.txt").location();
+    expect_overlapping(&image, from, from + 1, "",
+                       "after relocating other.txt");
+    expect_overlapping(&image, other, other + 3, "other.txt",
+                       "after relocating other.txt");
+    expect_overlapping(&image, other + 1, other + 3, "",
+                       "before other.txt grows");
+    image.modify_file(image.find("/other.txt"),
+                      [](iso9660::FileStream* stream, const iso9660::File&) {
+                        *stream << std::string(5000, 'o');
+                      });
+    expect_overlapping(&image, other + 2, other + 3, "other.txt",
+                       "after other.txt has grown");
+    image.write();
+  }
+  std::fstream isofile(argv[2], std::ios::binary | std::ios::in);
+  iso9660::Image image(&isofile);
+  image.read();
+  expect_overlapping(&image, readme, readme + 1, "same.txt",
+                     "after reading the image again");
+  expect_overlapping(&image, other, other + 3, "other.txt",
+                     "after reading the image again");
+  expect_overlapping(&image, other + 2, other + 3, "other.txt",
+                     "after reading the image again");
+  return test::result();
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#ifndef ISO9660_TEST_HELPERS_H_
+#define ISO9660_TEST_HELPERS_H_
+
+#include <cstdlib>
+#include <fstream>
+#include <ios>
+#include <iostream>
+#include <string>
+
+namespace test {
+
+/**
+ * Number of expectations that haven't been met. A test fails if it's not zero
+ * when it returns.
+ */
+inline int& failures() {
+  static int failures = 0;
+  return failures;
+}
+
+inline void expect(bool condition, const std::string& message) {
+  if (!condition) {
+    std::cerr << "FAILED: " << message << '\n';
+    ++failures();
+  }
+}
+
+inline int result() { return failures() == 0 ? 0 : 1; }
+
+/**
+ * Tests modify a copy of an image so that they can be run again.
+ */
+inline void copy_file(const std::string& from, const std::string& to) {
+  std::ifstream original(from, std::ios::binary);
+  std::ofstream copy(to, std::ios::binary | std::ios::trunc);
+  copy << original.rdbuf();
+  if (!original || !copy) {
+    std::cerr << "Can't copy " << from << " to " << to << '\n';
+    std::exit(1);
+  }
+}
+
+}  // namespace test
+
+#endif  // ISO9660_TEST_HELPERS_H_
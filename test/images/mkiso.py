@@ -0,0 +1,244 @@
+#!/usr/bin/env python3
+"""Write the small ISO 9660 images with Joliet extensions that the tests use.
+
+Usage: mkiso.py OUT.iso SPEC [COUNT]
+SPEC: 'empty-files' | 'extended-attributes' | 'shared-extent' |
+      'directories' | 'many-files'
+'many-files' puts COUNT (default 50000) empty files into the root directory
+for the benchmarks.
+"""
+import struct, sys
+
+SECTOR = 2048
+
+
+def both16(v): return struct.pack('<H', v) + struct.pack('>H', v)
+def both32(v): return struct.pack('<I', v) + struct.pack('>I', v)
+
+
+def short_dt():
+    return bytes([117, 6, 15, 12, 30, 45, 4])  # 2017-06-15 12:30:45 +01:00
+
+
+def long_dt(s='2017061512304500'):
+    return s.encode() + bytes([4])
+
+
+class Node:
+    def __init__(self, name, data=None, children=None, ear=0, shares=None,
+                 primary=None):
+        self.name = name
+        self.data = data
+        self.children = children
+        self.isdir = children is not None
+        # Logical blocks of the extended attribute record.
+        self.ear = ear
+        # A file whose extent the file refers to instead of having its own.
+        self.shares = shares
+        # Identifier in the primary volume descriptor if it's been shortened.
+        self.primary = primary
+
+
+def iso_name(n, isdir):
+    return n.upper() if isdir else n.upper() + ';1'
+
+
+def primary_name(node):
+    return node.primary or iso_name(node.name, node.isdir)
+
+
+def joliet_name(n, isdir):
+    return n.encode('utf-16-be')
+
+
+def record(ident, loc, size, isdir, ear=0):
+    ln = 33 + len(ident)
+    ln += ln % 2
+    r = bytes([ln, ear]) + both32(loc) + both32(size) + short_dt()
+    r += bytes([2 if isdir else 0, 0, 0]) + both16(1) + bytes([len(ident)]) + ident
+    return r.ljust(ln, b'\0')
+
+
+def pack_dir(records):
+    out = b''
+    cur = b''
+    for r in records:
+        if len(cur) + len(r) > SECTOR:
+            out += cur.ljust(SECTOR, b'\0')
+            cur = b''
+        cur += r
+    out += cur.ljust(SECTOR, b'\0')
+    return out
+
+
+def build(root, out):
+    # Collect directories breadth first (path table order).
+    dirs = [(root, 0)]  # (node, parent index 1-based)
+    i = 0
+    while i < len(dirs):
+        node, _ = dirs[i]
+        subs = sorted([c for c in node.children if c.isdir], key=lambda c: c.name.upper())
+        for s in subs:
+            dirs.append((s, i + 1))
+        i += 1
+    # Layout: 16 system, PVD 16, SVD 17, term 18, then path tables, dirs, files.
+    lba = 19
+    def count_records(node, joliet):
+        recs = [record(b'\0', 0, 0, True), record(b'\1', 0, 0, True)]
+        for c in node.children:
+            ident = joliet_name(c.name, c.isdir) if joliet else primary_name(c).encode()
+            recs.append(record(ident, 0, 0, c.isdir))
+        return len(pack_dir(recs)) // SECTOR
+
+    def pt(joliet, big):
+        out = b''
+        for node, parent in dirs:
+            if node is root:
+                ident = b'\0'
+            else:
+                ident = joliet_name(node.name, True) if joliet else primary_name(node).encode()
+            loc = node.jloc if joliet else node.loc
+            fmt = '>' if big else '<'
+            r = bytes([len(ident), 0]) + struct.pack(fmt + 'I', loc) + struct.pack(fmt + 'H', parent) + ident
+            if len(ident) % 2: r += b'\0'
+            out += r
+        return out
+    # Path table sizes need locations; compute sizes with dummy first.
+    for node, _ in dirs:
+        node.loc = node.jloc = 0
+    pt_size = {j: len(pt(j, False)) for j in (False, True)}
+    pt_secs = {j: (pt_size[j] + SECTOR - 1) // SECTOR for j in (False, True)}
+    ptloc = {}
+    for j in (False, True):
+        ptloc[(j, 'L')] = lba; lba += pt_secs[j]
+        ptloc[(j, 'M')] = lba; lba += pt_secs[j]
+    for j in (False, True):
+        for node, _ in dirs:
+            n = count_records(node, j)
+            if j:
+                node.jloc, node.jsize = lba, n * SECTOR
+            else:
+                node.loc, node.size = lba, n * SECTOR
+            lba += n
+    files = []
+    def walk(node):
+        for c in node.children:
+            if c.isdir: walk(c)
+            else: files.append(c)
+    walk(root)
+    empty = None
+    for f in files:
+        f.size = len(f.data)
+        if f.shares is not None:
+            continue
+        if f.size == 0 and empty is not None:
+            # Empty files share their extent like mkisofs does it.
+            f.loc = f.jloc = empty
+            continue
+        if f.size == 0: empty = lba
+        f.loc = lba
+        f.jloc = lba
+        lba += f.ear + max(1, (f.size + SECTOR - 1) // SECTOR)
+    for f in files:
+        if f.shares is not None:
+            f.loc = f.jloc = f.shares.loc
+    total = lba
+    img = bytearray(total * SECTOR)
+    def put(sec, data): img[sec * SECTOR: sec * SECTOR + len(data)] = data
+    # Directory extents.
+    parents = {}
+    for idx, (node, parent) in enumerate(dirs):
+        parents[id(node)] = dirs[parent - 1][0] if parent else node
+    for j in (False, True):
+        for node, _ in dirs:
+            par = parents[id(node)]
+            loc = node.jloc if j else node.loc
+            size = node.jsize if j else node.size
+            ploc = par.jloc if j else par.loc
+            psize = par.jsize if j else par.size
+            recs = [record(b'\0', loc, size, True), record(b'\1', ploc, psize, True)]
+            kids = []
+            for c in node.children:
+                ident = joliet_name(c.name, c.isdir) if j else primary_name(c).encode()
+                kids.append((ident, c))
+            kids.sort(key=lambda k: k[0])
+            for ident, c in kids:
+                if c.isdir:
+                    recs.append(record(ident, c.jloc if j else c.loc, c.jsize if j else c.size, True))
+                else:
+                    recs.append(record(ident, c.loc, c.size, False, c.ear))
+            put(loc, pack_dir(recs))
+    for f in files:
+        if f.shares is not None:
+            continue
+        # The content of extended attribute records doesn't matter here.
+        put(f.loc, b'E' * f.ear * SECTOR)
+        put(f.loc + f.ear, f.data)
+    for j in (False, True):
+        put(ptloc[(j, 'L')], pt(j, False))
+        put(ptloc[(j, 'M')], pt(j, True))
+    def vd(j):
+        d = bytes([2 if j else 1]) + b'CD001' + bytes([1, 0])
+        d += b'LINUX'.ljust(32) + b'TESTVOL'.ljust(32) + bytes(8) + both32(total)
+        d += (b'%/E' if j else b'').ljust(32, b'\0') + both16(1) + both16(1) + both16(SECTOR)
+        d += both32(pt_size[j]) + struct.pack('<I', ptloc[(j, 'L')]) + struct.pack('<I', 0)
+        d += struct.pack('>I', ptloc[(j, 'M')]) + struct.pack('>I', 0)
+        d += record(b'\0', root.jloc if j else root.loc, root.jsize if j else root.size, True)
+        d += b'VOLSET'.ljust(128) + b'PUBLISHER'.ljust(128) + b'PREPARER'.ljust(128)
+        d += b'APP'.ljust(128) + b'COPY'.ljust(37) + b'ABS'.ljust(37) + b'BIB'.ljust(37)
+        d += long_dt() + long_dt('2018010100000000') + long_dt('0000000000000000')[:-1] + b'\0' + long_dt()
+        d += bytes([1, 0]) + b'USE'.ljust(512) + bytes(653)
+        assert len(d) == SECTOR, len(d)
+        return d
+    put(16, vd(False))
+    put(17, vd(True))
+    put(18, bytes([255]) + b'CD001' + bytes([1]))
+    open(out, 'wb').write(img)
+
+
+def main():
+    out, spec = sys.argv[1], sys.argv[2]
+    if spec == 'empty-files':
+        # The names sort differently in both volume descriptors.
+        root = Node('', children=[
+            Node('Zeta', b''),
+            Node('alpha', b''),
+            Node('readme.txt', b'hello world\n'),
+            Node('sub', children=[Node('alpha', b'')]),
+        ])
+    elif spec == 'extended-attributes':
+        root = Node('', children=[
+            Node('one.txt', b'one block\n', ear=1),
+            Node('two.txt', b'two blocks\n', ear=2),
+            Node('none.txt', b'no blocks\n'),
+        ])
+    elif spec == 'shared-extent':
+        # An empty file and a duplicate refer to the extent of readme.txt.
+        readme = Node('readme.txt', b'hello world\n')
+        root = Node('', children=[
+            Node('empty', b'', shares=readme),
+            readme,
+            Node('same.txt', b'hello world\n', shares=readme),
+            Node('other.txt', b'other\n'),
+        ])
+    elif spec == 'directories':
+        # The primary name of the long directory has been cut short.
+        root = Node('', children=[
+            Node('longdirectoryname', primary='LONGDIRE', children=[
+                Node('a_b.txt', b'underscore\n'),
+            ]),
+            Node('readme.txt', b'hello world\n'),
+            Node('sub', children=[Node('file.txt', b'file\n')]),
+        ])
+    elif spec == 'many-files':
+        count = int(sys.argv[3]) if len(sys.argv) > 3 else 50000
+        root = Node('', children=[
+            Node('package-%05d.rpm' % i, b'') for i in range(count)
+        ])
+    else:
+        raise SystemExit('bad spec')
+    build(root, out)
+
+
+if __name__ == '__main__':
+    main()
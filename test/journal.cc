@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+/*
+ * The journal stages writes as dirty sectors and only fills in the bytes that
+ * haven't been written when it commits them. Sectors are committed in
+ * ascending order with adjacent ones written at once. Writes through an
+ * fstream reach the image before whatever has been staged for the same file.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "./include/iso9660.h"
+#include "./test/helpers.h"
+
+namespace {
+
+constexpr std::size_t SECTORS = 8;
+
+// Remembers where each run of sectors has been written.
+class RecordingSink : public iso9660::BlockSink {
+ public:
+  explicit RecordingSink(iso9660::BlockSink* sink) : sink_(sink) {}
+  void write(std::uint64_t offset, const iso9660::Byte* source,
+             std::size_t size) override {
+    sink_->write(offset, source, size);
+  }
+  void write_vectored(std::uint64_t offset, const iso9660::Span* spans,
+                      std::size_t count) override {
+    std::size_t size = 0;
+    for (std::size_t i = 0; i < count; ++i) size += spans[i].size();
+    runs.emplace_back(offset, size);
+    iso9660::BlockSink::write_vectored(offset, spans, count);
+  }
+
+  std::vector<std::pair<std::uint64_t, std::size_t>> runs;
+
+ private:
+  iso9660::BlockSink* sink_;
+};
+
+void write(iso9660::Journal* journal, std::uint64_t offset,
+           const std::string& data) {
+  journal->write(offset, reinterpret_cast<const iso9660::Byte*>(data.data()),
+                 data.size());
+}
+
+void expect_bytes(const std::vector<iso9660::Byte>& image,
+                  std::uint64_t offset, const std::string& expected,
+                  const std::string& message) {
+  test::expect(std::string(image.begin() + offset,
+                           image.begin() + offset + expected.size()) ==
+                   expected,
+               message);
+}
+
+void test_partial_sectors() {
+  std::vector<iso9660::Byte> image(SECTORS * iso9660::SECTOR_SIZE, '.');
+  iso9660::MemoryDevice device(image.data(), image.size());
+  iso9660::Journal journal(&device, &device);
+  // Crosses a word of the bitmask and a sector boundary.
+  write(&journal, 60, "0123456789");
+  write(&journal, iso9660::SECTOR_SIZE - 2, "wxyz");
+  write(&journal, 62, "AB");
+  test::expect(journal.dirty_sectors() == 2, "Two sectors are dirty");
+  expect_bytes(image, 60, "..........", "Nothing is written before commit");
+
+  std::string read(12, '\0');
+  journal.read(59, read.size(), reinterpret_cast<iso9660::Byte*>(&read[0]));
+  test::expect(read == ".01AB456789.", "Reads see the staged writes");
+
+  // The rest of a dirty sector is read on commit, not when it's staged.
+  image[100] = '!';
+  image[iso9660::SECTOR_SIZE + 5] = '?';
+  journal.commit(iso9660::Durability::NONE);
+  test::expect(journal.empty(), "Nothing is staged after commit");
+  expect_bytes(image, 59, ".01AB456789.", "Staged bytes are written");
+  expect_bytes(image, 100, "!", "Bytes that haven't been staged are kept");
+  expect_bytes(image, iso9660::SECTOR_SIZE - 3, ".wxyz.",
+               "A write across sectors is written to both");
+  expect_bytes(image, iso9660::SECTOR_SIZE + 5, "?",
+               "The rest of the second sector is kept");
+}
+
+void test_order() {
+  std::vector<iso9660::Byte> image(SECTORS * iso9660::SECTOR_SIZE, '.');
+  iso9660::MemoryDevice device(image.data(), image.size());
+  RecordingSink sink(&device);
+  iso9660::Journal journal(&device, &sink);
+  write(&journal, 5 * iso9660::SECTOR_SIZE, "five");
+  write(&journal, 3 * iso9660::SECTOR_SIZE + 7, "three");
+  write(&journal, 1 * iso9660::SECTOR_SIZE, "one");
+  write(&journal, 2 * iso9660::SECTOR_SIZE + 2047, "!");
+
+  // Only what overlaps the section is committed.
+  journal.commit(5 * iso9660::SECTOR_SIZE + 1, 1, iso9660::Durability::NONE);
+  test::expect(journal.dirty_sectors() == 3, "Three sectors stay staged");
+  expect_bytes(image, 5 * iso9660::SECTOR_SIZE, "five",
+               "The overlapping sector is written");
+  expect_bytes(image, 1 * iso9660::SECTOR_SIZE, "...",
+               "Other sectors aren't written");
+
+  journal.commit(iso9660::Durability::NONE);
+  const std::vector<std::pair<std::uint64_t, std::size_t>> runs = {
+      {5 * iso9660::SECTOR_SIZE, iso9660::SECTOR_SIZE},
+      {1 * iso9660::SECTOR_SIZE, 3 * iso9660::SECTOR_SIZE}};
+  test::expect(sink.runs == runs,
+               "Adjacent sectors are written at once in ascending order");
+  expect_bytes(image, 1 * iso9660::SECTOR_SIZE, "one", "Sector 1 is written");
+  expect_bytes(image, 2 * iso9660::SECTOR_SIZE + 2047, "!",
+               "Sector 2 is written");
+  expect_bytes(image, 3 * iso9660::SECTOR_SIZE + 6, ".three.",
+               "Sector 3 is written");
+
+  write(&journal, 0, "discarded");
+  journal.discard();
+  journal.commit(iso9660::Durability::NONE);
+  expect_bytes(image, 0, ".........", "Discarded writes aren't written");
+}
+
+std::string content(iso9660::Image* image, const std::string& path) {
+  std::string read;
+  image->read_file(image->find(path), [&read](iso9660::Span chunk) {
+    read.append(chunk.begin(), chunk.end());
+  });
+  return read;
+}
+
+void test_fstream(const std::string& original, const std::string& copy) {
+  test::copy_file(original, copy);
+  {
+    std::fstream isofile(copy,
+                         std::ios::binary | std::ios::in | std::ios::out);
+    iso9660::Image image(&isofile);
+    image.read();
+    const iso9660::File file = image.find("/sub/file.txt");
+    image.modify_file(
+        file, [](iso9660::BlockSink* sink, const iso9660::File& file) {
+          const char staged[] = "AAAAA";
+          sink->write(static_cast<std::uint64_t>(file.location()) *
+                              iso9660::SECTOR_SIZE +
+                          file.extended_length(),
+                      reinterpret_cast<const iso9660::Byte*>(staged),
+                      std::strlen(staged));
+          return std::streamsize(0);
+        });
+    image.modify_file(file, [](std::fstream* stream, const iso9660::File&) {
+      stream->seekp(stream->tellg() + std::streamoff(2));
+      *stream << "BB";
+      return std::streamsize(0);
+    });
+    image.write();
+  }
+  std::fstream isofile(copy, std::ios::binary | std::ios::in);
+  iso9660::Image image(&isofile);
+  image.read();
+  test::expect(content(&image, "/sub/file.txt") == "AABBA",
+               "Writes through an fstream win over earlier staged ones");
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <directories.iso> <copy.iso>\n"
+              << std::flush;
+    return 1;
+  }
+  test_partial_sectors();
+  test_order();
+  test_fstream(argv[1], argv[2]);
+  return test::result();
+}
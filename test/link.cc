@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+/*
+ * Empty files share their extent. Their records in both volume descriptors
+ * have to be linked by name so that removing one of them doesn't remove the
+ * primary record of another one. The names sort differently in both volume
+ * descriptors of the image: "Zeta" before "alpha" in the Joliet one and
+ * "ALPHA;1" before "ZETA;1" in the primary one. "sub/alpha" shares the extent
+ * as well.
+ */
+
+#include <fstream>
+#include <ios>
+#include <iostream>
+#include <string>
+
+#include "./include/iso9660.h"
+#include "./test/helpers.h"
+
+namespace {
+
+void expect_primary_name(iso9660::Image* image, const std::string& path,
+                         const std::string& primary_name) {
+  const iso9660::File file = image->find(path);
+  test::expect(static_cast<bool>(file), path + " exists");
+  if (!file) return;
+  test::expect(file.primary_name().str() == primary_name,
+               path + " is linked to " + file.primary_name().str() +
+                   " instead of " + primary_name);
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <empty-files.iso> <copy.iso>\n"
+              << std::flush;
+    return 1;
+  }
+  test::copy_file(argv[1], argv[2]);
+  {
+    std::fstream isofile(argv[2],
+                         std::ios::binary | std::ios::in | std::ios::out);
+    iso9660::Image image(&isofile);
+    image.read();
+    expect_primary_name(&image, "Zeta", "ZETA;1");
+    expect_primary_name(&image, "/alpha", "ALPHA;1");
+    expect_primary_name(&image, "/sub/alpha", "ALPHA;1");
+    image.remove_file(image.find("Zeta"));
+    image.write();
+  }
+  std::fstream isofile(argv[2], std::ios::binary | std::ios::in);
+  iso9660::Image image(&isofile);
+  image.read();
+  test::expect(!image.find("Zeta"), "Zeta has been removed");
+  expect_primary_name(&image, "/alpha", "ALPHA;1");
+  expect_primary_name(&image, "/sub/alpha", "ALPHA;1");
+  for (const auto& name : image.files().primary_names) {
+    test::expect(name.str() != "ZETA;1", "ZETA;1 has been removed");
+  }
+  return test::result();
+}
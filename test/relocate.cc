@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2017 squimrel
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+/*
+ * Every file that refers to an extent is moved along with it when one of them
+ * is relocated. The empty file of the image shares the extent of readme.txt
+ * and same.txt, so relocating it has to copy the content of the others. A
+ * reader that is already open follows a file that moves and grows.
+ */
+
+#include <fstream>
+#include <ios>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "./include/iso9660.h"
+#include "./test/helpers.h"
+
+namespace {
+
+std::string content(iso9660::Image* image, const std::string& path) {
+  std::string read;
+  const iso9660::File file = image->find(path);
+  test::expect(static_cast<bool>(file), path + " exists");
+  if (!file) return read;
+  image->read_file(file, [&read](iso9660::Span chunk) {
+    read.append(chunk.begin(), chunk.end());
+  });
+  return read;
+}
+
+void expect_files(iso9660::Image* image, std::size_t location) {
+  for (const char* const path : {"/empty", "/readme.txt", "/same.txt"}) {
+    test::expect(image->find(path).location() == location,
+                 std::string(path) + " is at sector " +
+                     std::to_string(location));
+  }
+  test::expect(image->find("/empty").size() == 0, "/empty is still empty");
+  test::expect(content(image, "/readme.txt") == "hello world\n",
+               "/readme.txt is intact");
+  test::expect(content(image, "/same.txt") == "hello world\n",
+               "/same.txt is intact");
+  test::expect(content(image, "/other.txt") == "other\n",
+               "/other.txt is intact");
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <shared-extent.iso> <copy.iso>\n"
+              << std::flush;
+    return 1;
+  }
+  test::copy_file(argv[1], argv[2]);
+  std::size_t location = 0;
+  {
+    std::fstream isofile(argv[2],
+                         std::ios::binary | std::ios::in | std::ios::out);
+    iso9660::Image image(&isofile);
+    image.read();
+    const std::size_t from = image.find("/readme.txt").location();
+    test::expect(image.find("/empty").location() == from,
+                 "/empty shares the extent of /readme.txt");
+    test::expect(image.relocate_file(image.find("/empty"), 100),
+                 "/empty is relocated");
+    location = image.find("/empty").location();
+    test::expect(location != from, "/empty has moved");
+    expect_files(&image, location);
+    image.write();
+  }
+  {
+    std::fstream isofile(argv[2], std::ios::binary | std::ios::in);
+    iso9660::Image image(&isofile);
+    image.read();
+    expect_files(&image, location);
+  }
+  {
+    // A reader follows a file that is relocated and grows before the image
+    // is written.
+    std::fstream isofile(argv[2],
+                         std::ios::binary | std::ios::in | std::ios::out);
+    iso9660::Image image(&isofile);
+    image.read();
+    iso9660::FileReader reader = image.reader(image.find("/other.txt"));
+    std::vector<iso9660::Byte> read(6000);
+    test::expect(reader.read(0, read.size(), read.data()) == 6,
+                 "The reader reads /other.txt");
+    test::expect(image.relocate_file(image.find("/other.txt"), 5000),
+                 "/other.txt is relocated");
+    image.modify_file(image.find("/other.txt"),
+                      [](iso9660::FileStream* stream, const iso9660::File&) {
+                        stream->seekp(0, std::ios::end);
+                        *stream << std::string(4000, 'o');
+                      });
+    test::expect(reader.read(0, read.size(), read.data()) == 4006,
+                 "The reader sees /other.txt grow");
+    test::expect(std::string(read.begin(), read.begin() + 4006) ==
+                     "other\n" + std::string(4000, 'o'),
+                 "The reader sees the new content of /other.txt");
+  }
+
+  // An image in memory can't grow so nothing may be touched.
+  std::ifstream isofile(argv[1], std::ios::binary);
+  std::vector<iso9660::Byte> original((std::istreambuf_iterator<char>(isofile)),
+                                      std::istreambuf_iterator<char>());
+  std::vector<iso9660::Byte> memory(original);
+  iso9660::MemoryDevice device(memory.data(), memory.size());
+  iso9660::Image image(&device, &device);
+  image.read();
+  bool thrown = false;
+  try {
+    image.relocate_file(image.find("/empty"), 100);
+  } catch (const iso9660::NotImplementedException&) {
+    thrown = true;
+  }
+  test::expect(thrown, "Relocating within memory throws");
+  image.write();
+  test::expect(memory == original, "The image in memory is unchanged");
+  return test::result();
+}